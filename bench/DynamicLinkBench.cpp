@@ -0,0 +1,387 @@
+//
+// Created by DS on 2025/12/04.
+//
+
+// DynamicLinkBench: call, resolve, load and reload overhead of DynamicLink.
+//
+// usage: DynamicLinkBench [--threads N] [--iterations N] [--rounds N] [--format json|csv]
+//
+// ns_per_op is wall time per operation seen by one thread, max_ns the worst
+// single operation where it is sampled (0 otherwise).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <DynamicLink.h>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using AddFunc = int(int, int);
+    using SymbolFunc = int(int);
+
+    const std::string pluginV1(BENCH_PLUGIN_V1);
+    const std::string pluginV2(BENCH_PLUGIN_V2);
+    constexpr unsigned symbolCount = 1000; // exported by fixtures/BenchPlugin.cpp
+
+    struct Options {
+        unsigned threads{std::max(1U, std::thread::hardware_concurrency())};
+        std::uint64_t iterations{10'000'000};
+        unsigned rounds{20};
+        bool csv{false};
+    };
+
+    struct Result {
+        std::string name;
+        unsigned threads;
+        std::uint64_t iterations;
+        double nsPerOp;
+        double maxNs;
+    };
+
+    std::vector<Result> results;
+    std::atomic<int> sink{0};
+
+    [[gnu::noinline]] int DirectAdd(const int a, const int b) {
+        return a + b;
+    }
+
+    double Nanoseconds(const Clock::duration duration) {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    std::vector<unsigned> ThreadCounts(const unsigned max) {
+        std::vector<unsigned> counts;
+        for (unsigned count = 1; count < max; count *= 2) {
+            counts.push_back(count);
+        }
+        counts.push_back(max);
+        return counts;
+    }
+
+    // starts every worker at once, returns the wall time until the last one finished
+    template<typename Body>
+    Clock::duration RunParallel(const unsigned threads, Body&& body) {
+        std::atomic<unsigned> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (unsigned index = 0; index < threads; ++index) {
+            workers.emplace_back([&, index] {
+                ready.fetch_add(1, std::memory_order_relaxed);
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                body(index);
+            });
+        }
+        while (ready.load(std::memory_order_relaxed) < threads) {
+            std::this_thread::yield();
+        }
+        const auto start = Clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        return Clock::now() - start;
+    }
+
+    std::vector<DynamicLink::FunctionWrapper<AddFunc>> MakeWrappers(const unsigned count) {
+        std::vector<DynamicLink::FunctionWrapper<AddFunc>> wrappers;
+        wrappers.reserve(count);
+        for (unsigned index = 0; index < count; ++index) {
+            wrappers.push_back(DynamicLink::GetFunction<AddFunc>(pluginV1, "bench_add"));
+        }
+        return wrappers;
+    }
+
+    template<typename Call>
+    void BenchCall(const char* name, const Options& options, const unsigned threads, Call&& call) {
+        const auto elapsed = RunParallel(threads, [&](const unsigned index) {
+            int accumulator = 0;
+            for (std::uint64_t i = 0; i < options.iterations; ++i) {
+                accumulator += call(index, static_cast<int>(i), accumulator);
+            }
+            sink.fetch_add(accumulator, std::memory_order_relaxed);
+        });
+        results.push_back({name, threads, options.iterations,
+            Nanoseconds(elapsed) / static_cast<double>(options.iterations), 0});
+    }
+
+    // like BenchCall, `body` runs the whole loop of one thread itself
+    template<typename Body>
+    void BenchLoop(const char* name, const Options& options, const unsigned threads, Body&& body) {
+        const auto elapsed = RunParallel(threads, [&](const unsigned index) {
+            sink.fetch_add(body(index, options.iterations), std::memory_order_relaxed);
+        });
+        results.push_back({name, threads, options.iterations,
+            Nanoseconds(elapsed) / static_cast<double>(options.iterations), 0});
+    }
+
+    void BenchCalls(const Options& options) {
+        for (const unsigned threads : ThreadCounts(options.threads)) {
+            DynamicLink::PreloadLibrary(pluginV1);
+            auto wrappers = MakeWrappers(threads);
+
+            BenchCall("call.direct", options, threads, [](unsigned, const int a, const int b) {
+                return DirectAdd(a, b);
+            });
+
+            std::vector<AddFunc*> raw;
+            for (auto& wrapper : wrappers) {
+                raw.push_back(wrapper.getRawPointer());
+            }
+            BenchCall("call.raw_pointer", options, threads, [&](const unsigned index, const int a, const int b) {
+                return raw[index](a, b);
+            });
+
+            AddFunc* stable = DynamicLink::GetStablePointer<AddFunc>(pluginV1, "bench_add");
+            BenchCall("call.stable_pointer", options, threads, [&](unsigned, const int a, const int b) {
+                return stable(a, b);
+            });
+
+            using BenchSymbol = DynamicLink::Symbol<BENCH_PLUGIN_V1, "bench_add", AddFunc>;
+            BenchSymbol::bind();
+            BenchCall("call.symbol", options, threads, [](unsigned, const int a, const int b) {
+                return BenchSymbol::call(a, b);
+            });
+
+            BenchCall("call.checked", options, threads, [&](const unsigned index, const int a, const int b) {
+                return wrappers[index](a, b);
+            });
+
+            for (auto& wrapper : wrappers) {
+                wrapper.setCheck(false);
+            }
+            BenchCall("call.unchecked", options, threads, [&](const unsigned index, const int a, const int b) {
+                return wrappers[index](a, b);
+            });
+
+            std::vector<DynamicLink::FastFunction<AddFunc>> fast;
+            for (unsigned index = 0; index < threads; ++index) {
+                fast.emplace_back(pluginV1, "bench_add");
+            }
+            BenchCall("call.fast", options, threads, [&](const unsigned index, const int a, const int b) {
+                return fast[index](a, b);
+            });
+
+            for (auto& wrapper : wrappers) {
+                wrapper.setCheck(true);
+            }
+            BenchLoop("call.scope", options, threads, [&](const unsigned index, const std::uint64_t iterations) {
+                auto scope = wrappers[index].scope();
+                int accumulator = 0;
+                for (std::uint64_t i = 0; i < iterations; ++i) {
+                    accumulator += scope(static_cast<int>(i), accumulator);
+                }
+                return accumulator;
+            });
+
+            BenchLoop("call.batch", options, threads, [&](const unsigned index, const std::uint64_t iterations) {
+                constexpr std::size_t batchSize = 1024;
+                std::vector<std::tuple<int, int>> rows(batchSize);
+                std::vector<int> values(batchSize);
+                int accumulator = 0;
+                for (std::uint64_t done = 0; done < iterations; done += batchSize) {
+                    const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(batchSize, iterations - done));
+                    for (std::size_t row = 0; row < count; ++row) {
+                        rows[row] = {static_cast<int>(done + row), accumulator};
+                    }
+                    wrappers[index].invokeBatch(std::span(rows).first(count), values);
+                    accumulator += values[count - 1];
+                }
+                return accumulator;
+            });
+
+            for (auto& wrapper : wrappers) {
+                wrapper.setFallback([](const int a, const int b) { return a - b; });
+            }
+            DynamicLink::UnloadLibrary(pluginV1);
+            BenchCall("call.fallback", options, threads, [&](const unsigned index, const int a, const int b) {
+                return wrappers[index](a, b);
+            });
+        }
+    }
+
+    std::vector<std::string> SymbolNames() {
+        std::vector<std::string> names;
+        names.reserve(symbolCount);
+        for (unsigned index = 0; index < symbolCount; ++index) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "bench_fn_%03u", index);
+            names.emplace_back(name);
+        }
+        return names;
+    }
+
+    void BenchResolve(const Options& options) {
+        const auto names = SymbolNames();
+        for (const unsigned threads : ThreadCounts(options.threads)) {
+            const unsigned slice = symbolCount / threads;
+            double total = 0;
+            std::atomic<std::int64_t> worst{0};
+            for (unsigned round = 0; round < options.rounds; ++round) {
+                DynamicLink::UnloadLibrary(pluginV1);
+                DynamicLink::PreloadLibrary(pluginV1);
+                total += Nanoseconds(RunParallel(threads, [&](const unsigned index) {
+                    for (unsigned i = index * slice; i < (index + 1) * slice; ++i) {
+                        const auto start = Clock::now();
+                        auto function = DynamicLink::GetFunction<SymbolFunc>(pluginV1, names[i]);
+                        const auto spent = static_cast<std::int64_t>(Nanoseconds(Clock::now() - start));
+                        std::int64_t seen = worst.load(std::memory_order_relaxed);
+                        while (spent > seen && !worst.compare_exchange_weak(seen, spent)) {}
+                        sink.fetch_add(function(1), std::memory_order_relaxed);
+                    }
+                }));
+            }
+            const std::uint64_t resolves = static_cast<std::uint64_t>(slice) * options.rounds;
+            results.push_back({"resolve.first_call", threads, resolves * threads,
+                total / static_cast<double>(resolves), static_cast<double>(worst.load())});
+        }
+    }
+
+    void BenchLoad(const Options& options) {
+        double total = 0;
+        double worst = 0;
+        for (unsigned round = 0; round < options.rounds; ++round) {
+            DynamicLink::UnloadLibrary(pluginV1);
+            const auto start = Clock::now();
+            DynamicLink::PreloadLibrary(pluginV1);
+            const double spent = Nanoseconds(Clock::now() - start);
+            total += spent;
+            worst = std::max(worst, spent);
+        }
+        results.push_back({"load.preload_library", 1, options.rounds, total / options.rounds, worst});
+
+        const auto names = SymbolNames();
+        total = 0;
+        worst = 0;
+        for (unsigned round = 0; round < options.rounds; ++round) {
+            DynamicLink::UnloadLibrary(pluginV1);
+            DynamicLink::PreloadLibrary(pluginV1);
+            for (const auto& name : names) {
+                const auto start = Clock::now();
+                DynamicLink::PreloadFunction(pluginV1, name);
+                const double spent = Nanoseconds(Clock::now() - start);
+                total += spent;
+                worst = std::max(worst, spent);
+            }
+        }
+        const std::uint64_t preloads = static_cast<std::uint64_t>(symbolCount) * options.rounds;
+        results.push_back({"load.preload_function", 1, preloads, total / static_cast<double>(preloads), worst});
+    }
+
+    // callers keep calling through checked wrappers while the main thread flips v1 <-> v2
+    void BenchReload(const Options& options) {
+        for (const unsigned threads : ThreadCounts(options.threads)) {
+            DynamicLink::UnloadLibrary(pluginV2);
+            DynamicLink::PreloadLibrary(pluginV1);
+            auto wrappers = MakeWrappers(threads);
+
+            std::atomic<bool> stop{false};
+            std::atomic<std::uint64_t> calls{0};
+            std::atomic<std::int64_t> worstCall{0};
+            double reloadTotal = 0;
+            double reloadWorst = 0;
+            std::thread reloader([&] {
+                for (unsigned round = 0; round < options.rounds; ++round) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    const bool forward = round % 2 == 0;
+                    const auto start = Clock::now();
+                    DynamicLink::ReloadLibrary(forward ? pluginV1 : pluginV2, forward ? pluginV2 : pluginV1);
+                    const double spent = Nanoseconds(Clock::now() - start);
+                    reloadTotal += spent;
+                    reloadWorst = std::max(reloadWorst, spent);
+                }
+                stop.store(true, std::memory_order_release);
+            });
+            const auto elapsed = RunParallel(threads, [&](const unsigned index) {
+                std::uint64_t count = 0;
+                std::int64_t worst = 0;
+                int accumulator = 0;
+                while (!stop.load(std::memory_order_acquire)) {
+                    const auto start = Clock::now();
+                    accumulator += wrappers[index](accumulator, 1);
+                    worst = std::max(worst, static_cast<std::int64_t>(Nanoseconds(Clock::now() - start)));
+                    ++count;
+                }
+                calls.fetch_add(count, std::memory_order_relaxed);
+                std::int64_t seen = worstCall.load(std::memory_order_relaxed);
+                while (worst > seen && !worstCall.compare_exchange_weak(seen, worst)) {}
+                sink.fetch_add(accumulator, std::memory_order_relaxed);
+            });
+            reloader.join();
+
+            results.push_back({"reload.duration", threads, options.rounds,
+                reloadTotal / options.rounds, reloadWorst});
+            const std::uint64_t perThread = std::max<std::uint64_t>(1, calls.load() / threads);
+            results.push_back({"reload.call_latency", threads, calls.load(),
+                Nanoseconds(elapsed) / static_cast<double>(perThread), static_cast<double>(worstCall.load())});
+        }
+        DynamicLink::UnloadLibrary(pluginV1);
+        DynamicLink::UnloadLibrary(pluginV2);
+    }
+
+    void Print(const Options& options) {
+        if (options.csv) {
+            std::printf("name,threads,iterations,ns_per_op,max_ns\n");
+            for (const auto& [name, threads, iterations, nsPerOp, maxNs] : results) {
+                std::printf("%s,%u,%llu,%.3f,%.0f\n", name.c_str(), threads,
+                    static_cast<unsigned long long>(iterations), nsPerOp, maxNs);
+            }
+            return;
+        }
+        std::printf("{\n  \"benchmarks\": [\n");
+        for (std::size_t index = 0; index < results.size(); ++index) {
+            const auto& [name, threads, iterations, nsPerOp, maxNs] = results[index];
+            std::printf("    {\"name\": \"%s\", \"threads\": %u, \"iterations\": %llu, "
+                "\"ns_per_op\": %.3f, \"max_ns\": %.0f}%s\n", name.c_str(), threads,
+                static_cast<unsigned long long>(iterations), nsPerOp, maxNs,
+                index + 1 == results.size() ? "" : ",");
+        }
+        std::printf("  ]\n}\n");
+    }
+
+    Options ParseOptions(const int argc, char** argv) {
+        Options options;
+        for (int index = 1; index < argc; ++index) {
+            const char* value = index + 1 < argc ? argv[index + 1] : nullptr;
+            if (std::strcmp(argv[index], "--threads") == 0 && value) {
+                options.threads = std::max(1, std::atoi(value));
+            } else if (std::strcmp(argv[index], "--iterations") == 0 && value) {
+                options.iterations = std::max(1LL, std::atoll(value));
+            } else if (std::strcmp(argv[index], "--rounds") == 0 && value) {
+                options.rounds = std::max(1, std::atoi(value));
+            } else if (std::strcmp(argv[index], "--format") == 0 && value) {
+                options.csv = std::strcmp(value, "csv") == 0;
+            } else {
+                std::fprintf(stderr, "usage: %s [--threads N] [--iterations N] [--rounds N] [--format json|csv]\n",
+                    argv[0]);
+                std::exit(EXIT_FAILURE);
+            }
+            ++index;
+        }
+        return options;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const Options options = ParseOptions(argc, argv);
+    Detail::AddSearchPath(BENCH_FIXTURE_DIR);
+
+    BenchCalls(options);
+    BenchResolve(options);
+    BenchLoad(options);
+    BenchReload(options);
+
+    Print(options);
+    return 0;
+}
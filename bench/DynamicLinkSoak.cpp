@@ -0,0 +1,321 @@
+//
+// Created by DS on 2025/12/22.
+//
+
+// DynamicLinkSoak: call latency and correctness while libraries are swapped underneath.
+//
+// usage: DynamicLinkSoak [--threads N] [--seconds N] [--interval-ms N] [--settle-us N]
+//                        [--mode reload|unload] [--format json|csv]
+//
+// Callers hammer FunctionWrapper calls into the fixture plugin while one thread keeps
+// reloading it between its two builds (or unloading and loading it again, calls then
+// go to a fallback). Every call is timed and counted as "window" when it overlapped a
+// reload or started less than --settle-us after one, as "steady" otherwise.
+//
+// A call that returns the build a finished reload replaced is a stale call. Stale calls
+// and crashes make the run fail, so the exit code can gate a release.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <DynamicLink.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using VersionFunc = int();
+
+    const std::string pluginV1(BENCH_PLUGIN_V1);
+    const std::string pluginV2(BENCH_PLUGIN_V2);
+    constexpr int unloadedVersion = 0; // returned by the fallback
+
+    enum class Mode { Reload, Unload };
+
+    struct Options {
+        unsigned threads{std::max(2U, std::thread::hardware_concurrency()) - 1};
+        unsigned seconds{10};
+        unsigned intervalMs{2};
+        unsigned settleUs{1000};
+        Mode mode{Mode::Reload};
+        bool csv{false};
+    };
+
+    // log-linear latency buckets: 32 per power of two, within about 3%
+    class Histogram {
+    public:
+        void record(const std::uint64_t ns) {
+            ++this->buckets[Bucket(ns)];
+            ++this->count;
+            this->max = std::max(this->max, ns);
+        }
+
+        void merge(const Histogram& other) {
+            for (std::size_t index = 0; index < bucketCount; ++index) {
+                this->buckets[index] += other.buckets[index];
+            }
+            this->count += other.count;
+            this->max = std::max(this->max, other.max);
+        }
+
+        // upper bound of the bucket holding the `quantile` sample
+        std::uint64_t percentile(const double quantile) const {
+            if (this->count == 0) {
+                return 0;
+            }
+            const auto rank = static_cast<std::uint64_t>(quantile * static_cast<double>(this->count - 1)) + 1;
+            std::uint64_t seen = 0;
+            for (std::size_t index = 0; index < bucketCount; ++index) {
+                seen += this->buckets[index];
+                if (seen >= rank) {
+                    return std::min(UpperBound(index), this->max);
+                }
+            }
+            return this->max;
+        }
+
+        std::uint64_t samples() const { return this->count; }
+        std::uint64_t worst() const { return this->max; }
+
+    private:
+        static constexpr unsigned subBits = 6;
+        static constexpr std::size_t bucketCount = (64 - subBits + 1) << subBits;
+
+        static std::size_t Bucket(const std::uint64_t ns) {
+            const unsigned width = static_cast<unsigned>(std::bit_width(ns));
+            if (width <= subBits) {
+                return static_cast<std::size_t>(ns);
+            }
+            const unsigned shift = width - subBits;
+            return (static_cast<std::size_t>(shift) << subBits) + static_cast<std::size_t>(ns >> shift);
+        }
+
+        static std::uint64_t UpperBound(const std::size_t bucket) {
+            const auto shift = static_cast<unsigned>(bucket >> subBits);
+            const std::uint64_t sub = bucket & ((1U << subBits) - 1);
+            return ((sub + 1) << shift) - 1;
+        }
+
+        std::array<std::uint64_t, bucketCount> buckets{};
+        std::uint64_t count{0};
+        std::uint64_t max{0};
+    };
+
+    struct alignas(64) CallerStats {
+        Histogram steady{};
+        Histogram window{};
+        std::uint64_t stale{0};
+    };
+
+    // seqlock around every swap: odd while one runs, `published` is only written while odd
+    std::atomic<std::uint64_t> swapSequence{0};
+    std::atomic<int> published{1};
+    std::atomic<std::int64_t> lastSwapEnd{0}; //< ns on Clock, start of the settle period
+    std::atomic<std::uint64_t> staleReports{0};
+
+    // written before the swaps start, read by the crash handler
+    std::atomic<const char*> phase{"startup"};
+
+    std::int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    void OnCrash(const int signal) {
+        // async-signal-safe: fixed strings and write() only
+        const char* running = phase.load(std::memory_order_relaxed);
+        const char* header = "DynamicLinkSoak: CRASH (signal ";
+        const char digits[3] = {static_cast<char>('0' + signal / 10 % 10), static_cast<char>('0' + signal % 10), ')'};
+#ifdef __linux__
+        static_cast<void>(write(STDERR_FILENO, header, std::strlen(header)));
+        static_cast<void>(write(STDERR_FILENO, digits, sizeof(digits)));
+        static_cast<void>(write(STDERR_FILENO, " during ", 8));
+        static_cast<void>(write(STDERR_FILENO, running, std::strlen(running)));
+        static_cast<void>(write(STDERR_FILENO, "\n", 1));
+#endif
+        std::_Exit(EXIT_FAILURE);
+    }
+
+    void InstallCrashHandlers() {
+        for (const int signal : {SIGSEGV, SIGBUS, SIGILL, SIGFPE}) {
+            std::signal(signal, OnCrash);
+        }
+    }
+
+    void Swap(const Options& options, const unsigned round) {
+        const bool forward = round % 2 == 0;
+        if (options.mode == Mode::Reload) {
+            DynamicLink::ReloadLibrary(forward ? pluginV1 : pluginV2, forward ? pluginV2 : pluginV1);
+            published.store(forward ? 2 : 1, std::memory_order_relaxed);
+        } else if (forward) {
+            DynamicLink::UnloadLibrary(pluginV1);
+            published.store(unloadedVersion, std::memory_order_relaxed);
+        } else {
+            DynamicLink::PreloadLibrary(pluginV1);
+            published.store(1, std::memory_order_relaxed);
+        }
+    }
+
+    struct SwapStats {
+        unsigned swaps{0};
+        Histogram duration{};
+    };
+
+    SwapStats RunSwaps(const Options& options, const std::atomic<bool>& stop) {
+        SwapStats stats;
+        phase.store(options.mode == Mode::Reload ? "reload" : "unload", std::memory_order_relaxed);
+        while (!stop.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.intervalMs));
+            const auto start = Now();
+            swapSequence.fetch_add(1, std::memory_order_acq_rel);
+            Swap(options, stats.swaps++);
+            lastSwapEnd.store(Now(), std::memory_order_relaxed);
+            swapSequence.fetch_add(1, std::memory_order_release);
+            stats.duration.record(static_cast<std::uint64_t>(Now() - start));
+        }
+        return stats;
+    }
+
+    void RunCaller(const Options& options, const std::atomic<bool>& stop, CallerStats& stats) {
+        auto version = DynamicLink::GetFunction<VersionFunc>(pluginV1, "bench_version");
+        version.setFallback([] { return unloadedVersion; });
+        const auto settle = static_cast<std::int64_t>(options.settleUs) * 1000;
+        while (!stop.load(std::memory_order_relaxed)) {
+            const std::uint64_t before = swapSequence.load(std::memory_order_acquire);
+            const int expected = published.load(std::memory_order_acquire); // keeps the second sequence read after it
+            const auto start = Now();
+            const int seen = version();
+            const auto end = Now();
+            const std::uint64_t after = swapSequence.load(std::memory_order_acquire);
+
+            const bool quiet = before == after && before % 2 == 0;
+            const auto latency = static_cast<std::uint64_t>(end - start);
+            if (quiet && start - lastSwapEnd.load(std::memory_order_relaxed) >= settle) {
+                stats.steady.record(latency);
+            } else {
+                stats.window.record(latency);
+            }
+            // no swap overlapped the call, it has to reach the build published before it
+            if (quiet && seen != expected) {
+                ++stats.stale;
+                if (staleReports.fetch_add(1, std::memory_order_relaxed) < 5) {
+                    std::fprintf(stderr, "DynamicLinkSoak: STALE call returned build %d, build %d is published\n",
+                        seen, expected);
+                }
+            }
+        }
+    }
+
+    void Print(const Options& options, const Histogram& steady, const Histogram& window, const SwapStats& swaps,
+        const std::uint64_t stale, const double seconds) {
+        const char* mode = options.mode == Mode::Reload ? "reload" : "unload";
+        const double throughput = static_cast<double>(steady.samples() + window.samples()) / seconds;
+        if (options.csv) {
+            std::printf("name,mode,threads,samples,p50_ns,p99_ns,p999_ns,max_ns\n");
+            for (const auto& [name, histogram] : {std::pair{"call.steady", &steady},
+                     std::pair{"call.window", &window}, std::pair{"swap.duration", &swaps.duration}}) {
+                std::printf("%s,%s,%u,%llu,%llu,%llu,%llu,%llu\n", name, mode, options.threads,
+                    static_cast<unsigned long long>(histogram->samples()),
+                    static_cast<unsigned long long>(histogram->percentile(0.50)),
+                    static_cast<unsigned long long>(histogram->percentile(0.99)),
+                    static_cast<unsigned long long>(histogram->percentile(0.999)),
+                    static_cast<unsigned long long>(histogram->worst()));
+            }
+            std::printf("# calls_per_second=%.0f swaps=%u stale=%llu\n",
+                throughput, swaps.swaps, static_cast<unsigned long long>(stale));
+            return;
+        }
+        const auto print = [](const char* name, const Histogram& histogram, const char* separator) {
+            std::printf("    \"%s\": {\"samples\": %llu, \"p50_ns\": %llu, \"p99_ns\": %llu, "
+                "\"p999_ns\": %llu, \"max_ns\": %llu}%s\n", name,
+                static_cast<unsigned long long>(histogram.samples()),
+                static_cast<unsigned long long>(histogram.percentile(0.50)),
+                static_cast<unsigned long long>(histogram.percentile(0.99)),
+                static_cast<unsigned long long>(histogram.percentile(0.999)),
+                static_cast<unsigned long long>(histogram.worst()), separator);
+        };
+        std::printf("{\n  \"mode\": \"%s\", \"threads\": %u, \"seconds\": %.3f,\n", mode, options.threads, seconds);
+        std::printf("  \"calls_per_second\": %.0f, \"swaps\": %u, \"stale_calls\": %llu,\n",
+            throughput, swaps.swaps, static_cast<unsigned long long>(stale));
+        std::printf("  \"latency\": {\n");
+        print("steady", steady, ",");
+        print("window", window, ",");
+        print("swap", swaps.duration, "");
+        std::printf("  }\n}\n");
+    }
+
+    Options ParseOptions(const int argc, char** argv) {
+        Options options;
+        for (int index = 1; index < argc; ++index) {
+            const char* value = index + 1 < argc ? argv[index + 1] : nullptr;
+            if (std::strcmp(argv[index], "--threads") == 0 && value) {
+                options.threads = std::max(1, std::atoi(value));
+            } else if (std::strcmp(argv[index], "--seconds") == 0 && value) {
+                options.seconds = std::max(1, std::atoi(value));
+            } else if (std::strcmp(argv[index], "--interval-ms") == 0 && value) {
+                options.intervalMs = std::max(0, std::atoi(value));
+            } else if (std::strcmp(argv[index], "--settle-us") == 0 && value) {
+                options.settleUs = std::max(0, std::atoi(value));
+            } else if (std::strcmp(argv[index], "--mode") == 0 && value
+                && (std::strcmp(value, "reload") == 0 || std::strcmp(value, "unload") == 0)) {
+                options.mode = std::strcmp(value, "unload") == 0 ? Mode::Unload : Mode::Reload;
+            } else if (std::strcmp(argv[index], "--format") == 0 && value) {
+                options.csv = std::strcmp(value, "csv") == 0;
+            } else {
+                std::fprintf(stderr, "usage: %s [--threads N] [--seconds N] [--interval-ms N] [--settle-us N] "
+                    "[--mode reload|unload] [--format json|csv]\n", argv[0]);
+                std::exit(EXIT_FAILURE);
+            }
+            ++index;
+        }
+        return options;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const Options options = ParseOptions(argc, argv);
+    InstallCrashHandlers();
+    Detail::AddSearchPath(BENCH_FIXTURE_DIR);
+    DynamicLink::PreloadLibrary(pluginV1);
+
+    std::vector<CallerStats> stats(options.threads);
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> callers;
+    callers.reserve(options.threads);
+    for (unsigned index = 0; index < options.threads; ++index) {
+        callers.emplace_back([&, index] { RunCaller(options, stop, stats[index]); });
+    }
+    const auto start = Clock::now();
+    SwapStats swaps;
+    std::thread swapper([&] { swaps = RunSwaps(options, stop); });
+    std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+    stop.store(true, std::memory_order_relaxed);
+    swapper.join();
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    phase.store("shutdown", std::memory_order_relaxed);
+
+    Histogram steady;
+    Histogram window;
+    std::uint64_t stale = 0;
+    for (const auto& caller : stats) {
+        steady.merge(caller.steady);
+        window.merge(caller.window);
+        stale += caller.stale;
+    }
+    Print(options, steady, window, swaps, stale, seconds);
+    return stale == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
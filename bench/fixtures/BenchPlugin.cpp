@@ -0,0 +1,34 @@
+//
+// Created by DS on 2025/12/04.
+//
+
+// Fixture plugin for DynamicLinkBench, built once per BENCH_PLUGIN_VERSION so
+// the benchmark can hot-reload between two files exporting the same symbols.
+
+#ifdef _WIN32
+#define BENCH_EXPORT extern "C" __declspec(dllexport)
+#else
+#define BENCH_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+#ifndef BENCH_PLUGIN_VERSION
+#define BENCH_PLUGIN_VERSION 1
+#endif
+
+BENCH_EXPORT int bench_version() {
+    return BENCH_PLUGIN_VERSION;
+}
+
+BENCH_EXPORT int bench_add(const int a, const int b) {
+    return a + b;
+}
+
+// bench_fn_000 ... bench_fn_999, used to measure first-call resolution
+#define BENCH_FN(n) BENCH_EXPORT int bench_fn_##n(const int a) { return a + BENCH_PLUGIN_VERSION; }
+#define BENCH_FN10(n) BENCH_FN(n##0) BENCH_FN(n##1) BENCH_FN(n##2) BENCH_FN(n##3) BENCH_FN(n##4) \
+    BENCH_FN(n##5) BENCH_FN(n##6) BENCH_FN(n##7) BENCH_FN(n##8) BENCH_FN(n##9)
+#define BENCH_FN100(n) BENCH_FN10(n##0) BENCH_FN10(n##1) BENCH_FN10(n##2) BENCH_FN10(n##3) BENCH_FN10(n##4) \
+    BENCH_FN10(n##5) BENCH_FN10(n##6) BENCH_FN10(n##7) BENCH_FN10(n##8) BENCH_FN10(n##9)
+
+BENCH_FN100(0) BENCH_FN100(1) BENCH_FN100(2) BENCH_FN100(3) BENCH_FN100(4)
+BENCH_FN100(5) BENCH_FN100(6) BENCH_FN100(7) BENCH_FN100(8) BENCH_FN100(9)
@@ -12,10 +12,29 @@
  * and calling functions with support for hot-reloading and fallback mechanisms.
  */
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "internal/DescriptorTable.h"
+#include "internal/Epoch.h"
+#include "internal/InterfaceTable.h"
+#include "internal/LoadOptions.h"
+#include "internal/ReloadState.h"
+#include "internal/StaticSymbol.h"
+#include "internal/WrapperPolicies.h"
 
 namespace DynamicLink {
-struct FunctionDescriptor;
 
 template<typename T>
 concept Callable = std::is_function_v<T> && !std::is_member_function_pointer_v<T>;
@@ -23,13 +42,24 @@ concept Callable = std::is_function_v<T> && !std::is_member_function_pointer_v<T
 * @brief Core class contains safe dynamic function call
 *
 * @tparam FuncType: the dynamic function's real type
+* @tparam Check: CheckRuntime (default, see setCheck), CheckAlways or CheckNever
+* @tparam Fallback: FunctionFallback (default), InlineFallback<Capacity> or NoFallback
+* @tparam Lock: EpochLocked (default) keeps the library loaded during a checked call,
+*      Unlocked only compares the generation
 *
 * @warning illegal FuncType will cause fatal at the function calling
+* @note a wrapper caches the resolved pointer together with the library generation it
+*      was resolved at, a checked call costs one acquire load and a compare as long as
+*      no library is unloaded/reloaded. One instance is not synchronized, give every
+*      thread its own wrapper.
+*      `FunctionWrapper<F, CheckNever, NoFallback>` is a single indirect call
 **/
-template<Callable FuncType>
+template<Callable FuncType, typename Check = CheckRuntime, typename Fallback = FunctionFallback,
+    typename Lock = EpochLocked>
 class FunctionWrapper {
 public:
     using FuncPointer = std::add_pointer_t<FuncType>;
+    using ReturnType = typename Detail::FunctionTraits<FuncType>::Return;
     explicit FunctionWrapper(const std::string& libName, const std::string& funcName) noexcept;
     FunctionWrapper(FunctionWrapper&&) = default;
     FunctionWrapper& operator=(FunctionWrapper&&) = default;
@@ -37,20 +67,83 @@ public:
     /**
     * @brief main function to dynamic calls
     *
-    * @param args: the legal arguments the dynamic need, defined by the template FuncType
+    * @param args: forwarded as they are to the parameters of FuncType, nothing is copied
+    *      on the way
     * @return defined by the template FuncType
     **/
     template<typename... Args>
-    auto operator()(Args... args)
-    -> std::invoke_result_t<FuncType*, Args...>;
+        requires std::is_invocable_r_v<ReturnType, FuncPointer, Args...>
+    ReturnType operator()(Args&&... args);
+
+    /**
+     * @brief the function validated and pinned once for a run of calls
+     *
+     * Every call through the scope goes to the version that was current when it was
+     * opened, a reload or unload can't take effect before the scope closes. With
+     * EpochLocked the pinned version also stays loaded until then.
+     *
+     * @warning must not outlive the wrapper, don't unload/reload the library from
+     *      inside the scope on the same thread
+     */
+    class CallScope {
+    public:
+        explicit CallScope(FunctionWrapper& wrapper);
+        ~CallScope();
+        CallScope(const CallScope&) = delete;
+        CallScope& operator=(const CallScope&) = delete;
+
+        template<typename... Args>
+            requires std::is_invocable_r_v<ReturnType, FuncPointer, Args...>
+        ReturnType operator()(Args&&... args);
+
+        // false when the calls go to the fallback
+        explicit operator bool() const noexcept;
+
+    private:
+        [[no_unique_address]] Detail::LockScope<Lock> lock;
+        FunctionWrapper& wrapper;
+        FuncPointer function;
+        std::uint64_t calls{0};
+    };
+
+    /**
+     * @brief open a CallScope, e.g. around a loop over many rows
+     *
+     * @code
+     * auto scope = transform.scope();
+     * for (auto& row : rows) row.value = scope(row.value);
+     * @endcode
+     */
+    CallScope scope();
+
+    /**
+     * @brief call the function once per argument tuple, pinned like a CallScope
+     *
+     * The batch runs either entirely through the raw pointer or entirely through the
+     * fallback, the check happens once.
+     *
+     * @param arguments range of std::tuple holding the arguments of each call
+     * @param results receives the return values, at least as large as `arguments`
+     */
+    template<std::ranges::random_access_range Arguments>
+        requires (!std::is_void_v<ReturnType>) && Detail::TupleInvocable<FuncPointer, ReturnType,
+            std::remove_cvref_t<std::ranges::range_reference_t<const Arguments>>>::value
+    void invokeBatch(const Arguments& arguments, std::span<ReturnType> results);
+
+    // overload for functions returning void
+    template<std::ranges::random_access_range Arguments>
+        requires std::is_void_v<ReturnType> && Detail::TupleInvocable<FuncPointer, ReturnType,
+            std::remove_cvref_t<std::ranges::range_reference_t<const Arguments>>>::value
+    void invokeBatch(const Arguments& arguments);
 
     /**
      * @brief set the fallback function when the dynamic function accidentally failed
      *
-     * @tparam T any callables
+     * @tparam T any callables, InlineFallback only takes the ones fitting its capacity
      * @param func when can't call the dynamic function will call this function as fallback
      */
     template<typename  T>
+        requires Detail::FallbackStorage<Fallback, typename Detail::FunctionTraits<FuncType>::Signature>::enabled
     void setFallback(T&& func);
 
     /**
@@ -61,22 +154,61 @@ public:
      * @param isCheck true for enable checking, false for disable
      *
      * @warning when disable checking you should be responsible for the correct state
+     * @note only with CheckRuntime, the other policies decide at compile time
      */
-    void setCheck(bool isCheck);
+    void setCheck(bool isCheck) requires std::is_same_v<Check, CheckRuntime>;
 
     /**
      * @brief for the best performance get the raw for calling
      *
      * @return the raw pointer of the dynamic function
      * @note the pointer will cause error after unload/reload library,
-     *      return null when fail to load function
+     *      return null when fail to load function, see GetStablePointer for a
+     *      pointer that survives a reload
      */
     FuncPointer getRawPointer();
+
+private:
+    template<typename F, typename... Policies>
+    friend std::optional<FunctionWrapper<F, Policies...>> TryGetFunction(const std::string& lib,
+        const std::string& func);
+    // from a descriptor resolved at `current`, for TryGetFunction
+    FunctionWrapper(Detail::LibraryId lib, Detail::SymbolId func, Detail::DescriptorHandle descriptor,
+        std::uint64_t current) noexcept;
+
+    FuncPointer refresh(std::uint64_t currentGeneration);
+    bool checked() const noexcept;
+    // the address for the generation seen by `scope`, refreshed when it is outdated
+    template<typename Scope>
+    FuncPointer validate(const Scope& scope);
+
+    template<typename... Args>
+    ReturnType invokeFallback(Args&&... args);
+
+    FuncPointer function{nullptr}; //< cached dynamic function's address
+    std::uint64_t generation{0};   //< library generation the cached address belongs to
+    Detail::DescriptorHandle descriptor{}; //< slot the address is re-read from after a reload
+    std::uint32_t library{0}; //< interned library name, see Detail::InternName
+    std::uint32_t symbol{0};  //< interned function name
+    [[no_unique_address]] Detail::FallbackStorage<Fallback,
+        typename Detail::FunctionTraits<FuncType>::Signature> fallback{}; //< when can't call dynamic function,
+                                                                           // use this one
+    [[no_unique_address]] Detail::CheckState<Check> check{};
 };
+
+/**
+ * @brief unchecked wrapper without fallback, a call is a single indirect call
+ *
+ * @warning the library must stay loaded while it is used, see CheckNever
+ */
+template<Callable FuncType>
+using FastFunction = FunctionWrapper<FuncType, CheckNever, NoFallback>;
+
 /**
  * @brief Core function with creates a type-safe wrapper for a dynamically loaded function
  *
  * @tparam FuncType Function signature (e.g., void(int, const char*))
+ * @tparam Policies optional Check, Fallback and Lock policies of the FunctionWrapper
  * @param lib Library filename (e.g., "libmylib.so", "mydll.dll")
  * @param func Function name (e.g., "my_function")
  * @return FunctionWrapper<FuncType> Callable function object
@@ -85,10 +217,248 @@ public:
  * // Example usage:
  * auto func = GetFunction<void(int)>("libmathlib.so", "square");
  * func(5);  // Calls the dynamically loaded function
+ * auto fast = GetFunction<void(int), CheckNever, NoFallback>("libmathlib.so", "square");
  * @endcode
  */
-template<typename FuncType>
-FunctionWrapper<FuncType> GetFunction(const std::string& lib, const std::string& func);
+template<typename FuncType, typename... Policies>
+FunctionWrapper<FuncType, Policies...> GetFunction(const std::string& lib, const std::string& func);
+
+/**
+ * @brief GetFunction for optional entry points, empty instead of fatal when missing
+ *
+ * A missing symbol is remembered per library until it is reloaded, probing it again
+ * costs a hash lookup rather than a symbol table walk.
+ *
+ * @return the wrapper, std::nullopt when the library or the function can't be found
+ *
+ * @code
+ * if (auto hook = DynamicLink::TryGetFunction<void(Frame&)>("libplugin.so", "on_frame")) {
+ *     (*hook)(frame);
+ * }
+ * @endcode
+ */
+template<typename FuncType, typename... Policies>
+std::optional<FunctionWrapper<FuncType, Policies...>> TryGetFunction(const std::string& lib,
+    const std::string& func);
+
+/**
+ * @brief whether the library exports the function, loads the library when needed
+ *
+ * @note cached like TryGetFunction, a missing library is looked for again on every call
+ */
+bool HasFunction(const std::string& lib, const std::string& func);
+
+/**
+ * @brief get a plain function pointer that stays valid across reload and unload
+ *
+ * The pointer is a small per-function trampoline (x86-64 and AArch64 Linux) that jumps
+ * through a slot, ReloadLibrary points the slot at the new function and UnloadLibrary
+ * at `fallback`. It can be handed to C code, e.g. as a callback.
+ *
+ * @tparam FuncType Function signature (e.g., void(int, const char*))
+ * @param lib Library filename
+ * @param func Function name
+ * @param fallback called while the library is unloaded, without one such a call is fatal
+ * @return the trampoline, the same pointer on every call for the function
+ *
+ * @note calls through the trampoline are not epoch guarded, so a library that a trampoline
+ *      ever pointed into stays mapped after it is reloaded or unloaded (RTLD_NODELETE)
+ * @note the fallback passed first for a function is kept
+ */
+template<Callable FuncType>
+FuncType* GetStablePointer(const std::string& lib, const std::string& func, FuncType* fallback = nullptr);
+
+/**
+ * @brief a function named entirely at compile time, resolved once into a static slot
+ *
+ * Every use of the same `Symbol<Library, Function, FuncType>` shares one slot holding
+ * the function's address, objects of the type are empty. The slot starts at a bootstrap
+ * that interns the names, loads the library and binds the slot on the first call, after
+ * that a call is a load of the slot plus an indirect call. ReloadLibrary rewrites the slot,
+ * UnloadLibrary puts the bootstrap back so the next call loads the library again.
+ *
+ * @tparam Library Library filename as a string literal
+ * @tparam Function Function name as a string literal
+ * @tparam FuncType Function signature, C variadic functions are not supported
+ * @tparam Lock Unlocked (default) or EpochLocked, which keeps the library loaded during the call
+ *
+ * @code
+ * using Decode = DynamicLink::Symbol<"libcodec", "decode_frame", int(const uint8_t*, size_t)>;
+ * int status = Decode::call(data, size);
+ * @endcode
+ *
+ * @note with Unlocked the calls are not epoch guarded, the library stays mapped after it is
+ *      reloaded or unloaded, like for GetStablePointer
+ */
+template<Detail::FixedString Library, Detail::FixedString Function, Callable FuncType, typename Lock = Unlocked>
+class Symbol {
+public:
+    using FuncPointer = std::add_pointer_t<FuncType>;
+    using ReturnType = typename Detail::FunctionTraits<FuncType>::Return;
+
+    template<typename... Args>
+        requires std::is_invocable_r_v<ReturnType, FuncPointer, Args...>
+    static ReturnType call(Args&&... args);
+
+    template<typename... Args>
+        requires std::is_invocable_r_v<ReturnType, FuncPointer, Args...>
+    ReturnType operator()(Args&&... args) const;
+
+    // resolves ahead of the first call, fatal when the function can't be found
+    static void bind();
+
+private:
+    using Signature = typename Detail::FunctionTraits<FuncType>::Signature; //< without noexcept
+    using Bootstrap = Detail::SlotBootstrap<Symbol, Signature>;
+    friend Bootstrap;
+
+    static_assert(sizeof(Signature*) == sizeof(uintptr_t) && std::atomic<Signature*>::is_always_lock_free,
+        "the slot is rewritten as a plain address");
+    constinit static inline std::atomic<Signature*> slot{&Bootstrap::entry}; //< the bootstrap until bound
+};
+
+/**
+ * @brief one entry of an interface's constexpr name table
+ *
+ * @tparam Interface struct made of plain function pointers
+ * @tparam Pointer type of the member, e.g. int(*)(int)
+ */
+template<typename Interface, typename Pointer>
+struct SymbolBinding {
+    Pointer Interface::* member;
+    const char* name;
+};
+
+//< binds a member to the exported symbol of the same name
+#define DYNAMICLINK_SYMBOL(Interface, member) ::DynamicLink::SymbolBinding{&Interface::member, #member}
+
+/**
+* @brief a whole plugin ABI resolved in one pass
+*
+* @tparam Interface struct of function pointers with a `static constexpr std::tuple symbols`
+*      of SymbolBinding entries
+*
+* @note reload swaps the whole table at once, a caller never sees symbols of two versions.
+*      `operator->` pins the current table for the duration of the call
+**/
+template<typename Interface>
+class BoundInterface {
+public:
+    // keeps the library of the pinned table loaded while alive
+    class Scope {
+    public:
+        // `required` makes an unavailable table fatal instead of an empty scope
+        Scope(const Detail::InterfaceTable* interface, bool required) noexcept;
+        const Interface* operator->() const noexcept;
+        const Interface& operator*() const noexcept;
+        explicit operator bool() const noexcept;
+
+    private:
+        Detail::EpochGuard guard;
+        const Interface* table;
+    };
+
+    explicit BoundInterface(Detail::InterfaceTable* interface) noexcept;
+
+    /**
+     * @brief call through the current table, e.g. `codec->decode(data, size)`
+     *
+     * @warning fatal when the library has been unloaded and can't be re-attached
+     */
+    Scope operator->() const;
+
+    /**
+     * @brief pin the current table for several calls, empty when the library is unavailable
+     */
+    Scope pin() const;
+
+    /**
+     * @return whether every symbol of the interface is currently resolved
+     */
+    bool available() const;
+
+private:
+    Detail::InterfaceTable* interface;
+};
+
+/**
+ * @brief resolves every symbol of an interface in one pass
+ *
+ * @tparam Interface struct of function pointers with a constexpr name table
+ * @param lib Library filename, loaded when needed
+ * @return BoundInterface<Interface> fatal when a symbol is missing
+ *
+ * @note binding the same interface of the same library again shares the first binding
+ *
+ * @code
+ * struct CodecApi {
+ *     int (*decode)(const uint8_t*, size_t);
+ *     void (*reset)();
+ *     static constexpr auto symbols = std::tuple{
+ *         DYNAMICLINK_SYMBOL(CodecApi, decode),
+ *         DynamicLink::SymbolBinding{&CodecApi::reset, "codec_reset"}};
+ * };
+ * auto codec = BindInterface<CodecApi>("libcodec.so");
+ * codec->decode(data, size);
+ * @endcode
+ */
+template<typename Interface>
+BoundInterface<Interface> BindInterface(const std::string& lib);
+
+/**
+ * @brief name of an isolated copy of a library
+ *
+ * Every instance name is loaded with `dlmopen(LM_ID_NEWLM)` into a linker namespace of
+ * its own, so the copies share no global state. The name works everywhere a library
+ * name does, e.g. `ReloadLibrary(LibraryInstance(old, i), LibraryInstance(new, i))`.
+ *
+ * @param lib Library filename
+ * @param index instance number
+ * @return `lib#index`
+ *
+ * @note Linux only, glibc allows at most 15 namespaces besides the main one
+ */
+std::string LibraryInstance(const std::string& lib, std::size_t index);
+
+/**
+ * @brief the instance a thread is routed to
+ *
+ * @return a per-thread ordinal modulo `count`, stable for the lifetime of the thread
+ */
+std::size_t ThreadShard(std::size_t count);
+
+/**
+ * @brief an interface bound once per isolated library instance
+ *
+ * Every calling thread is routed to its own instance (see ThreadShard), so plugins that
+ * keep global state behind a lock scale with the number of instances.
+ */
+template<typename Interface>
+class ShardedInterface {
+public:
+    explicit ShardedInterface(std::vector<BoundInterface<Interface>> shards) noexcept;
+
+    // call through the calling thread's instance
+    typename BoundInterface<Interface>::Scope operator->() const;
+    typename BoundInterface<Interface>::Scope pin() const;
+
+    const BoundInterface<Interface>& shard(std::size_t index) const noexcept;
+    std::size_t size() const noexcept;
+
+private:
+    std::vector<BoundInterface<Interface>> shards;
+};
+
+/**
+ * @brief loads `count` isolated instances of a library and binds the interface in each
+ *
+ * @code
+ * auto codec = BindInterfaceShards<CodecApi>("libcodec.so", 4); // libcodec.so#0 .. #3
+ * codec->decode(data, size);
+ * @endcode
+ */
+template<typename Interface>
+ShardedInterface<Interface> BindInterfaceShards(const std::string& lib, std::size_t count);
 
 /**
  * @brief Preloads a library into memory without resolving any functions
@@ -105,6 +475,54 @@ FunctionWrapper<FuncType> GetFunction(const std::string& lib, const std::string&
  */
 void PreloadLibrary(const std::string& lib);
 
+/**
+ * @brief Loads a library image that only exists in memory
+ *
+ * The image is copied into a sealed anonymous file (memfd) and loaded from there, nothing is
+ * written to disk. From then on `lib` names that image for every lookup, ahead of the search
+ * paths, so it can be called, reloaded and unloaded like a library on disk; registering another
+ * image under the same name only affects later loads.
+ *
+ * @param lib Library name the image is registered under
+ * @param image Complete shared object, it may be released once the call returns
+ *
+ * @warning an image that can't be registered or loaded is fatal, like PreloadLibrary
+ * @note memory images are not watched, swap them with ReloadLibrary
+ *
+ * @code
+ * const auto image = FetchPlugin("codec");
+ * DynamicLink::PreloadLibraryFromMemory("codec", std::as_bytes(std::span(image)));
+ * @endcode
+ */
+void PreloadLibraryFromMemory(const std::string& lib, std::span<const std::byte> image);
+
+/**
+ * @brief Loads every library of a bundle, an uncompressed tar archive of shared objects
+ *
+ * Each member is registered like PreloadLibraryFromMemory under its file name, or under
+ * "<prefix>/<file name>" when a prefix is given, so a second version of the same bundle can be
+ * registered next to the first one and swapped in with ReloadLibrary. Members are loaded in
+ * dependency order, read from their DT_NEEDED entries, and a dependency reaches another member
+ * through that member's DT_SONAME.
+ *
+ * @param bundle Path of the archive, it is only read during the call
+ * @param prefix Optional namespace for the member names
+ * @return the library names of the members, in archive order
+ *
+ * @warning an unreadable bundle or a member that can't be loaded is fatal
+ * @warning the loader binds a dependency to the first loaded library with that soname, so a
+ *      member needing a soname that is already loaded (e.g. the previous version of a bundled
+ *      dependency), one needing a member without that soname, or a dependency cycle is refused
+ *      as fatal too: hot swapping a bundle works for members that don't need each other
+ *
+ * @code
+ * DynamicLink::PreloadBundle("plugins-v1.tar");
+ * DynamicLink::PreloadBundle("plugins-v2.tar", "v2");
+ * DynamicLink::ReloadLibrary("libcodec.so", "v2/libcodec.so");
+ * @endcode
+ */
+std::vector<std::string> PreloadBundle(const std::string& bundle, const std::string& prefix = {});
+
 /**
  * @brief Unloads a library from memory
  *
@@ -118,16 +536,259 @@ void UnloadLibrary(const std::string& lib);
  * @brief Hot-reload a library with an another version
  *
  * Switches all function calls from the old library to the new one automatically.
+ * The new library is loaded and resolved before anything is switched, callers are never
+ * blocked by the load. The old library is closed in the background once every call
+ * still running on it has returned.
+ *
+ * Libraries exporting the ReloadState hooks hand their state over and warm up before the
+ * switch, also off the callers' path. A failing hook aborts the reload: the new library is
+ * closed again and the old one keeps serving.
  *
  * @param oldLib Current library filename
  * @param newLib New library filename to replace with
+ * @return false when oldLib is not loaded (e.g. unloaded meanwhile) or a reload hook refused
+ *      the new version
  *
  * @code
  * // Update to new version without restarting
  * ReloadLibrary("plugin_v1.so", "plugin_v2.so");
  * @endcode
  */
-void ReloadLibrary(const std::string& oldLib, const std::string& newLib);
+bool ReloadLibrary(const std::string& oldLib, const std::string& newLib);
+
+/**
+ * @brief Lists the functions a library exports, e.g. to discover plugin entry points
+ *
+ * @param lib Library filename, loaded when needed
+ * @param prefix only names starting with it, everything when empty
+ * @return exported function names in symbol table order
+ *
+ * @note reads the ELF symbol table of the loaded image, empty on other platforms
+ *
+ * @code
+ * for (const auto& name : DynamicLink::ListFunctions("libfilters.so", "filter_")) {
+ *     filters.push_back(DynamicLink::GetFunction<void(Image&)>("libfilters.so", name));
+ * }
+ * @endcode
+ */
+std::vector<std::string> ListFunctions(const std::string& lib, std::string_view prefix = {});
+
+/**
+ * @brief Also resolves library names through the sonames listed in /etc/ld.so.cache
+ *
+ * Names the search paths don't hold, such as "libm.so.6", are looked up in the loader's cache
+ * as the dynamic loader itself would, entries of other ABIs and hwcaps variants are skipped.
+ * Search paths keep precedence.
+ *
+ * @param enable whether the next index rebuild includes the loader cache
+ *
+ * @note Linux only
+ *
+ * @code
+ * DynamicLink::UseLoaderCache(true);
+ * auto cosine = DynamicLink::GetFunction<double(double)>("libm.so.6", "cos");
+ * @endcode
+ */
+void UseLoaderCache(bool enable);
+
+/**
+ * @brief Keeps resolved symbol offsets on disk so the next start skips symbol lookup
+ *
+ * One file per library under `directory`, keyed by the library path and checked against
+ * its ELF build-id (size and mtime when it has none), a rebuilt library starts a fresh
+ * file. Files are written at exit or when a library is released, through a rename so a
+ * crash never leaves a torn file.
+ *
+ * @param directory cache location, created when missing, empty disables the cache
+ *
+ * @note affects libraries loaded afterwards, ELF only
+ */
+void EnableSymbolCache(const std::string& directory);
+
+/**
+ * @brief Does the loader work of a prefork server once in the parent
+ *
+ * Libraries given options through SetLoadOptions but not loaded yet are loaded with
+ * Binding::Now (their configured options stay as they are for later loads), retired libraries
+ * are closed, unbound interfaces are bound again and every loaded image is prefaulted. Workers
+ * forked afterwards share the resolved, populated pages. The first call also installs
+ * pthread_atfork handlers that hold every lock of the library across fork(), so a child never
+ * inherits one taken mid-operation. A child starts its own perf map from the parent's.
+ *
+ * @code
+ * DynamicLink::SetLoadOptions("libcodec.so", {});
+ * DynamicLink::PreloadFunction("libcodec.so", "decode_frame");
+ * DynamicLink::PrepareForFork();
+ * for (int i = 0; i < workers; ++i) if (fork() == 0) return serve();
+ * @endcode
+ *
+ * @warning don't fork from inside a dynamic call or from a library constructor run by
+ *      the loader, the handlers would wait for the forking thread itself
+ * @note libraries loaded lazily before the call keep their lazy PLT, set Binding::Now up
+ *      front for them. A child doesn't watch libraries, WatchLibrary stays with the parent.
+ *      Linux only, elsewhere only the loading and prefaulting happen.
+ */
+void PrepareForFork();
+
+/**
+ * @brief How a library is loaded from now on, including reloads into a new version
+ *
+ * Replaces the process wide dlopen flag. For the lowest latency right after a (re)load
+ * bind eagerly and prewarm, so neither lazy PLT binding nor page faults on cold text
+ * land on the first calls:
+ *
+ * @code
+ * SetLoadOptions("librenderer.so", {.binding = Binding::Now, .prewarm = true});
+ * @endcode
+ *
+ * @param lib Library filename, the same name it is loaded with; an isolated instance
+ *      `lib#i` uses the options of `lib` unless it has its own
+ * @param options dlopen flags and post load steps
+ *
+ * @note a reload keeps the options of the old library when the new one has none, the
+ *      cached symbols of a reload are always resolved before it is published
+ */
+void SetLoadOptions(const std::string& lib, const LoadOptions& options);
+
+/**
+ * @brief Options of every library without its own, lazy local binding by default
+ */
+void SetDefaultLoadOptions(const LoadOptions& options);
+
+/**
+ * @brief Back the code of libraries loaded afterwards with transparent huge pages
+ *
+ * After loading, the 2 MiB aligned part of every executable segment is copied into
+ * huge page backed anonymous memory that replaces the file mapping, which cuts iTLB
+ * misses for plugins with a large code footprint. Without THP, or for text smaller than
+ * a huge page, the library is loaded unchanged.
+ *
+ * @param enable true to remap, false (default) to load libraries as they are,
+ *      sets LoadOptions::hugePages of the defaults
+ *
+ * @note Linux only; remapped text is no longer file backed, profilers resolve it
+ *      through the symbol table of the library
+ */
+void UseHugePages(bool enable);
+
+/**
+ * @brief Name generated and relocated code for perf
+ *
+ * Every library loaded afterwards and every trampoline (see GetStablePointer) gets one
+ * `address size name [library]` line per function in `/tmp/perf-<pid>.map`. perf uses
+ * it for samples in anonymous text, e.g. huge page remapped code.
+ *
+ * @param enable true to write entries from now on
+ */
+void EnablePerfMap(bool enable);
+
+/**
+ * @brief Start recording a timeline of the loader phases
+ *
+ * Covers path resolution, dlopen, symbol resolution, reload prepare/publish, unload
+ * drain and dlclose. Nothing is recorded on the call path.
+ */
+void StartTrace();
+
+/**
+ * @brief Stop recording and write the timeline in Chrome trace-event format
+ *
+ * @param file JSON output, viewable in chrome://tracing or Perfetto
+ * @return false when the file can't be written
+ */
+bool StopTrace(const std::string& file);
+
+/**
+ * @brief How much of a loaded library's code currently sits on huge pages
+ *
+ * @return bytes, 0 when the library is not loaded or nothing was remapped
+ */
+std::size_t HugePageBytes(const std::string& lib);
+
+/**
+ * @brief log2 bucketed durations, `buckets[i]` counts samples of [2^(i-1), 2^i) ns
+ */
+struct LatencyHistogram {
+    std::array<std::uint64_t, 32> buckets{};
+
+    std::uint64_t samples() const;
+    /**
+     * @param fraction e.g. 0.99
+     * @return upper bound in ns of the bucket holding that percentile, 0 without samples
+     */
+    std::uint64_t percentile(double fraction) const;
+};
+
+/**
+ * @brief counters of one cached function, latency only covers the sampled calls
+ */
+struct FunctionStats {
+    std::string library;
+    std::string function;
+    std::uint64_t calls{0};
+    std::uint64_t fallbacks{0};
+    LatencyHistogram latency{};
+};
+
+struct OperationStats {
+    std::uint64_t count{0};
+    std::uint64_t totalNanoseconds{0};
+    std::uint64_t maxNanoseconds{0};
+    LatencyHistogram latency{};
+};
+
+struct StatsSnapshot {
+    bool enabled{false};                  //< false when built without DYNAMICLINK_TELEMETRY
+    std::vector<FunctionStats> functions; //< every currently cached function
+    std::uint64_t fallbacks{0};           //< all fallback calls, also of unloaded functions
+    OperationStats resolve{};             //< symbol lookups on a cache miss
+    OperationStats load{};                //< library loads
+    OperationStats reload{};              //< whole ReloadLibrary calls
+    OperationStats reloadPublish{};       //< part of a reload holding the cache locks
+    OperationStats lockWait{};            //< waits for an exclusive cache lock
+};
+
+/**
+ * @brief sums the per-thread telemetry counters
+ *
+ * Built with `-DDYNAMICLINK_TELEMETRY=ON` every call through a FunctionWrapper is counted,
+ * one call in DYNAMICLINK_TELEMETRY_SAMPLE (64 by default) per thread is timed. Without it
+ * the probes compile to nothing and the snapshot is empty.
+ *
+ * @code
+ * for (const auto& function : DynamicLink::Stats().functions) {
+ *     std::cout << function.function << ' ' << function.calls << ' '
+ *               << function.latency.percentile(0.99) << "ns\n";
+ * }
+ * @endcode
+ */
+StatsSnapshot Stats();
+
+/**
+ * @brief Reloads a library automatically whenever its file is rebuilt
+ *
+ * A watcher thread follows the library's directory with inotify. Once the file has been
+ * quiet for `debounce`, the new build is copied to a unique shadow path and reloaded like
+ * ReloadLibrary, wrappers and interfaces bound to `lib` switch to it. Nothing happens
+ * while the library is not loaded.
+ *
+ * @param lib Library filename, resolved like a load
+ * @param debounce quiet time after the last write before reloading
+ *
+ * @code
+ * DynamicLink::WatchLibrary("libgameplay.so");
+ * auto tick = DynamicLink::GetFunction<void(float)>("libgameplay.so", "tick");
+ * // rebuilding libgameplay.so swaps `tick` without a restart
+ * @endcode
+ */
+void WatchLibrary(const std::string& lib, std::chrono::milliseconds debounce = std::chrono::milliseconds(200));
+
+/**
+ * @brief Stops reloading a library automatically, the loaded version stays
+ *
+ * @param lib Library filename passed to WatchLibrary
+ */
+void UnwatchLibrary(const std::string& lib);
 
 /**
  * @brief Preloads a specific function from a library
@@ -139,6 +800,48 @@ void ReloadLibrary(const std::string& oldLib, const std::string& newLib);
  */
 void PreloadFunction(const std::string& lib, const std::string& func);
 
+/**
+ * @brief one library of an asynchronous preload and the functions to resolve with it
+ */
+struct PreloadRequest {
+    std::string library;
+    std::vector<std::string> functions{};
+};
+
+/**
+ * @brief Preloads many libraries concurrently on a bounded worker pool
+ *
+ * Library files are located and read ahead in parallel, their DT_NEEDED entries decide
+ * the order: a library of the batch starts loading once the libraries it needs from the
+ * same batch are loaded, independent ones overlap. The functions of each request are
+ * resolved right after their library, like PreloadFunction does.
+ *
+ * @param requests libraries and their functions, duplicates are merged
+ * @return completion handle, ready when every library of the batch is loaded
+ *
+ * @warning a library that can't be loaded is fatal, like PreloadLibrary
+ * @note the returned future blocks in its destructor until the batch is done
+ *
+ * @code
+ * DynamicLink::PreloadRequest plugins[] = {
+ *     {"libcore.so"},
+ *     {"librenderer.so", {"render_frame", "resize"}},
+ *     {"libphysics.so", {"update_physics"}}};
+ * auto loading = DynamicLink::PreloadLibrariesAsync(plugins);
+ * // ... other startup work
+ * loading.wait();
+ * @endcode
+ */
+std::future<void> PreloadLibrariesAsync(std::span<const PreloadRequest> requests);
+
+/**
+ * @brief Preloads many libraries concurrently without resolving any functions
+ *
+ * @param libs Library filenames
+ * @return completion handle, ready when every library is loaded
+ */
+std::future<void> PreloadLibrariesAsync(std::span<const std::string> libs);
+
 } // namespace DynamicLink
 
 #include "DynamicLink.ipp"
@@ -5,127 +5,365 @@
 #ifndef DYNAMICLINK_DYNAMICLINK_IPP
 #define DYNAMICLINK_DYNAMICLINK_IPP
 
+#include <format>
 #include <functional>
 #include <iostream>
 #include <memory>
-#include <shared_mutex>
+#include <optional>
+#include <ranges>
 #include <string>
+#include <tuple>
+#include <vector>
 #include "internal//DynamicLinkImpl.h"
 
 namespace DynamicLink {
 
+#define DYNAMICLINK_WRAPPER_TEMPLATE \
+    template<Callable FuncType, typename Check, typename Fallback, typename Lock>
+#define DYNAMICLINK_WRAPPER FunctionWrapper<FuncType, Check, Fallback, Lock>
 
-    template<typename T>
-    concept Callable = std::is_function_v<T> && !std::is_member_function_pointer_v<T>;
-    template<Callable FuncType>
-    class FunctionWrapper {
-    public:
-        using FuncPointer = std::add_pointer_t<FuncType>;
-        explicit FunctionWrapper(const std::string& libName, const std::string& funcName) noexcept {
-            this->descriptor = Detail::GetFunctionImpl(libName, funcName);
-            if (!this->descriptor || !this->descriptor->functionPointer) {
-                std::cerr << std::format("dynamic function not found, here is the system error:\n",
-                    GET_ERROR());
-                std::terminate();
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    DYNAMICLINK_WRAPPER::FunctionWrapper(const std::string& libName, const std::string& funcName) noexcept {
+        const auto current = Detail::libraryGeneration.load(std::memory_order_acquire);
+        this->library = Detail::InternName(libName);
+        this->symbol = Detail::InternName(funcName);
+        this->descriptor = Detail::GetFunctionImpl(this->library, this->symbol);
+        this->function = reinterpret_cast<FuncPointer>(Detail::LoadDescriptor(this->descriptor));
+        if (!this->function) {
+            std::cerr << std::format("dynamic function not found, here is the system error:\n{}",
+                GET_ERROR());
+            std::terminate();
+        }
+        this->generation = current;
+    }
+
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    DYNAMICLINK_WRAPPER::FunctionWrapper(const Detail::LibraryId lib, const Detail::SymbolId func,
+        const Detail::DescriptorHandle descriptor, const std::uint64_t current) noexcept
+        : function(reinterpret_cast<FuncPointer>(Detail::LoadDescriptor(descriptor))), generation(current),
+          descriptor(descriptor), library(lib), symbol(func) {}
+
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    template<typename... Args>
+        requires std::is_invocable_r_v<typename DYNAMICLINK_WRAPPER::ReturnType,
+            typename DYNAMICLINK_WRAPPER::FuncPointer, Args...>
+    typename DYNAMICLINK_WRAPPER::ReturnType
+    DYNAMICLINK_WRAPPER::operator()(Args&&... args) {
+        [[maybe_unused]] const Detail::CallProbe probe(this->descriptor.index);
+        if (!this->checked()) {
+            if constexpr (!decltype(this->fallback)::enabled) {
+                return std::invoke(this->function, std::forward<Args>(args)...);
+            } else {
+                if (this->function) [[likely]] {
+                    return std::invoke(this->function, std::forward<Args>(args)...);
+                }
+                return this->invokeFallback(std::forward<Args>(args)...);
             }
-            this->libName = libName;
-            this->funcName = funcName;
         }
 
-        FunctionWrapper(FunctionWrapper&&) = default;
-        FunctionWrapper& operator=(FunctionWrapper&&) = default;
+        // with EpochLocked the scope keeps the library mapped until this call returns
+        const Detail::LockScope<Lock> scope;
+        if (const FuncPointer current = this->validate(scope)) [[likely]] {
+            return std::invoke(current, std::forward<Args>(args)...);
+        }
+        return this->invokeFallback(std::forward<Args>(args)...);
+    }
 
-        template<typename... Args>
-        auto operator()(Args... args)
-        -> std::invoke_result_t<FuncType*, Args...> {
-            using ReturnType = std::invoke_result_t<FuncType*, Args...>;
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    template<typename Scope>
+    typename DYNAMICLINK_WRAPPER::FuncPointer
+    DYNAMICLINK_WRAPPER::validate(const Scope& scope) {
+        if (scope.generation() != this->generation) [[unlikely]] {
+            return this->refresh(scope.generation());
+        }
+        return this->function;
+    }
 
-            if (this->check){
-                if (Detail::DescriptorShouldUpdate(libName)) {
-                    this->libName = Detail::GetActualLibraryName(this->libName);
-                    this->descriptor = Detail::GetFunctionImpl(libName, funcName);
-                }
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    DYNAMICLINK_WRAPPER::CallScope::CallScope(FunctionWrapper& wrapper)
+        : wrapper(wrapper), function(wrapper.validate(this->lock)) {}
 
-                if (!this->descriptor->functionPointer) {
-                    if (this->fallback){
-                        std::cerr << "invalid dynamic function call: library has unloaded with no fallback";
-                        std::terminate();
-                    }
-                } else {
-                    std::cerr << "invalid dynamic function call: library has unloaded with no fallback";
-                    std::terminate();
-                }
-            } // check
-
-            std::shared_lock<std::shared_mutex> lock(this->descriptor->valid);
-
-            if constexpr (std::is_void_v<ReturnType>) {
-                if (!this->descriptor->functionPointer) {
-                    if (this->fallback) {
-                        std::invoke(
-                            std::forward<std::function<FuncType>>(this->fallback),
-                            std::forward<Args>(args)...
-                            );
-                    } else {
-                        std:: cerr << "invalid dynamic function call: library has unloaded with no fallback";
-                        std::terminate();
-                    }
-                } else {
-                    std::invoke(
-                       reinterpret_cast<FuncPointer>(this->descriptor->functionPointer),
-                       std::forward<Args>(args)...
-                       );
-                }
-                return;
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    DYNAMICLINK_WRAPPER::CallScope::~CallScope() {
+        Detail::RecordCalls(this->wrapper.descriptor.index, this->calls);
+    }
+
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    template<typename... Args>
+        requires std::is_invocable_r_v<typename DYNAMICLINK_WRAPPER::ReturnType,
+            typename DYNAMICLINK_WRAPPER::FuncPointer, Args...>
+    typename DYNAMICLINK_WRAPPER::ReturnType
+    DYNAMICLINK_WRAPPER::CallScope::operator()(Args&&... args) {
+        if constexpr (Detail::telemetryEnabled) {
+            ++this->calls;
+        }
+        if (this->function) [[likely]] {
+            return std::invoke(this->function, std::forward<Args>(args)...);
+        }
+        return this->wrapper.invokeFallback(std::forward<Args>(args)...);
+    }
+
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    DYNAMICLINK_WRAPPER::CallScope::operator bool() const noexcept {
+        return this->function != nullptr;
+    }
+
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    typename DYNAMICLINK_WRAPPER::CallScope
+    DYNAMICLINK_WRAPPER::scope() {
+        return CallScope(*this);
+    }
+
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    template<std::ranges::random_access_range Arguments>
+        requires (!std::is_void_v<typename DYNAMICLINK_WRAPPER::ReturnType>)
+            && Detail::TupleInvocable<typename DYNAMICLINK_WRAPPER::FuncPointer,
+                typename DYNAMICLINK_WRAPPER::ReturnType,
+                std::remove_cvref_t<std::ranges::range_reference_t<const Arguments>>>::value
+    void DYNAMICLINK_WRAPPER::invokeBatch(const Arguments& arguments, std::span<ReturnType> results) {
+        const auto count = static_cast<std::size_t>(std::ranges::size(arguments));
+        if (results.size() < count) {
+            std::cerr << std::format("invokeBatch: {} results for {} calls", results.size(), count);
+            std::terminate();
+        }
+        const Detail::LockScope<Lock> scope;
+        Detail::RecordCalls(this->descriptor.index, count);
+        if (const FuncPointer function = this->validate(scope)) [[likely]] {
+            for (std::size_t index = 0; index < count; ++index) {
+                results[index] = std::apply(function, arguments[index]);
             }
-            else {
-                ReturnType res;
-                if (!this->descriptor->functionPointer) {
-                    if (this->fallback) {
-                        res = std::invoke(
-                            std::forward<std::function<FuncType>>(this->fallback),
-                            std::forward<Args>(args)...
-                            );
-                    } else {
-                        std:: cerr << "invalid dynamic function call: library has unloaded with no fallback";
-                        std::terminate();
-                    }
-                } else {
-                    res = std::invoke(
-                       reinterpret_cast<FuncPointer>(this->descriptor->functionPointer),
-                       std::forward<Args>(args)...
-                       );
-                }
-                return res;
+            return;
+        }
+        for (std::size_t index = 0; index < count; ++index) {
+            results[index] = std::apply([this](const auto&... args) {
+                return this->invokeFallback(args...);
+            }, arguments[index]);
+        }
+    }
+
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    template<std::ranges::random_access_range Arguments>
+        requires std::is_void_v<typename DYNAMICLINK_WRAPPER::ReturnType>
+            && Detail::TupleInvocable<typename DYNAMICLINK_WRAPPER::FuncPointer,
+                typename DYNAMICLINK_WRAPPER::ReturnType,
+                std::remove_cvref_t<std::ranges::range_reference_t<const Arguments>>>::value
+    void DYNAMICLINK_WRAPPER::invokeBatch(const Arguments& arguments) {
+        const Detail::LockScope<Lock> scope;
+        Detail::RecordCalls(this->descriptor.index, std::ranges::size(arguments));
+        if (const FuncPointer function = this->validate(scope)) [[likely]] {
+            for (const auto& call : arguments) {
+                std::apply(function, call);
             }
+            return;
+        }
+        for (const auto& call : arguments) {
+            std::apply([this](const auto&... args) { this->invokeFallback(args...); }, call);
         }
+    }
 
-        template<typename  T>
-        void setFallback(T&& func) {
-            this->fallback = std::make_unique<std::function<FuncType>>(std::forward<T>(func));
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    bool DYNAMICLINK_WRAPPER::checked() const noexcept {
+        if constexpr (std::is_same_v<Check, CheckRuntime>) {
+            return this->check.enabled;
+        } else {
+            return std::is_same_v<Check, CheckAlways>;
         }
+    }
 
-        void setCheck(bool isCheck) {
-            this->check = isCheck;
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    template<typename... Args>
+    typename DYNAMICLINK_WRAPPER::ReturnType
+    DYNAMICLINK_WRAPPER::invokeFallback(Args&&... args) {
+        Detail::RecordFallback(this->descriptor.index);
+        return this->fallback(std::forward<Args>(args)...);
+    }
+
+    // slow path, only taken after a library was unloaded/reloaded
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    typename DYNAMICLINK_WRAPPER::FuncPointer
+    DYNAMICLINK_WRAPPER::refresh(const std::uint64_t currentGeneration) {
+        auto address = Detail::LoadDescriptor(this->descriptor);
+        if (address == 0U) {
+            // the slot was released by an unload, look the function up again by name
+            this->library = Detail::GetActualLibrary(this->library);
+            this->descriptor = Detail::FindFunctionImpl(this->library, this->symbol);
+            address = Detail::LoadDescriptor(this->descriptor);
         }
+        this->function = reinterpret_cast<FuncPointer>(address);
+        this->generation = currentGeneration;
+        return this->function;
+    }
+
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    template<typename  T>
+        requires Detail::FallbackStorage<Fallback, typename Detail::FunctionTraits<FuncType>::Signature>::enabled
+    void DYNAMICLINK_WRAPPER::setFallback(T&& func) {
+        this->fallback.set(std::forward<T>(func));
+    }
+
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    void DYNAMICLINK_WRAPPER::setCheck(bool isCheck) requires std::is_same_v<Check, CheckRuntime> {
+        this->check.enabled = isCheck;
+    }
 
-        FuncPointer getRawPointer() {
-            return reinterpret_cast<FuncPointer>(this->descriptor->functionPointer);
+    DYNAMICLINK_WRAPPER_TEMPLATE
+    typename DYNAMICLINK_WRAPPER::FuncPointer
+    DYNAMICLINK_WRAPPER::getRawPointer() {
+        if (this->checked()) {
+            if (const Detail::LockScope<Lock> scope; scope.generation() != this->generation) {
+                return this->refresh(scope.generation());
+            }
         }
+        return this->function;
+    }
 
-    private:
-        Detail::FunctionDescriptor* descriptor{nullptr};//< save the dynamic function's address
-        std::string libName;
-        std::string funcName;
-        std::unique_ptr<std::function<FuncType>> fallback; //< when can't call dynamic function,
-                                                           // use this one (all callable objects)
-        bool check{true};
-    };
-    template<typename FuncType>
-    FunctionWrapper<FuncType> GetFunction(const std::string& lib, const std::string& func){
-        FunctionWrapper<FuncType> function(lib, func);
+#undef DYNAMICLINK_WRAPPER
+#undef DYNAMICLINK_WRAPPER_TEMPLATE
+
+    template<typename FuncType, typename... Policies>
+    FunctionWrapper<FuncType, Policies...> GetFunction(const std::string& lib, const std::string& func){
+        FunctionWrapper<FuncType, Policies...> function(lib, func);
         return function;
     }
+
+    template<typename FuncType, typename... Policies>
+    std::optional<FunctionWrapper<FuncType, Policies...>> TryGetFunction(const std::string& lib,
+        const std::string& func) {
+        const auto current = Detail::libraryGeneration.load(std::memory_order_acquire);
+        const auto library = Detail::InternName(lib);
+        const auto symbol = Detail::InternName(func);
+        const auto descriptor = Detail::TryGetFunctionImpl(library, symbol);
+        if (Detail::LoadDescriptor(descriptor) == 0) {
+            return std::nullopt;
+        }
+        return FunctionWrapper<FuncType, Policies...>(library, symbol, descriptor, current);
+    }
+
+    template<typename Interface>
+    ShardedInterface<Interface>::ShardedInterface(std::vector<BoundInterface<Interface>> shards) noexcept
+        : shards(std::move(shards)) {}
+
+    template<typename Interface>
+    typename BoundInterface<Interface>::Scope ShardedInterface<Interface>::operator->() const {
+        return this->shards[ThreadShard(this->shards.size())].operator->();
+    }
+
+    template<typename Interface>
+    typename BoundInterface<Interface>::Scope ShardedInterface<Interface>::pin() const {
+        return this->shards[ThreadShard(this->shards.size())].pin();
+    }
+
+    template<typename Interface>
+    const BoundInterface<Interface>& ShardedInterface<Interface>::shard(const std::size_t index) const noexcept {
+        return this->shards[index];
+    }
+
+    template<typename Interface>
+    std::size_t ShardedInterface<Interface>::size() const noexcept {
+        return this->shards.size();
+    }
+
+    template<typename Interface>
+    ShardedInterface<Interface> BindInterfaceShards(const std::string& lib, const std::size_t count) {
+        std::vector<BoundInterface<Interface>> shards;
+        shards.reserve(count);
+        for (std::size_t index = 0; index < count; ++index) {
+            shards.push_back(BindInterface<Interface>(LibraryInstance(lib, index)));
+        }
+        return ShardedInterface<Interface>(std::move(shards));
+    }
+
+    template<Callable FuncType>
+    FuncType* GetStablePointer(const std::string& lib, const std::string& func, FuncType* fallback) {
+        return reinterpret_cast<FuncType*>(Detail::GetStablePointerImpl(Detail::InternName(lib),
+            Detail::InternName(func), reinterpret_cast<uintptr_t>(fallback)));
+    }
+
+    template<Detail::FixedString Library, Detail::FixedString Function, Callable FuncType, typename Lock>
+    template<typename... Args>
+        requires std::is_invocable_r_v<typename Symbol<Library, Function, FuncType, Lock>::ReturnType,
+            typename Symbol<Library, Function, FuncType, Lock>::FuncPointer, Args...>
+    typename Symbol<Library, Function, FuncType, Lock>::ReturnType
+    Symbol<Library, Function, FuncType, Lock>::call(Args&&... args) {
+        [[maybe_unused]] const Detail::LockScope<Lock> scope{};
+        return slot.load(std::memory_order_acquire)(std::forward<Args>(args)...);
+    }
+
+    template<Detail::FixedString Library, Detail::FixedString Function, Callable FuncType, typename Lock>
+    template<typename... Args>
+        requires std::is_invocable_r_v<typename Symbol<Library, Function, FuncType, Lock>::ReturnType,
+            typename Symbol<Library, Function, FuncType, Lock>::FuncPointer, Args...>
+    typename Symbol<Library, Function, FuncType, Lock>::ReturnType
+    Symbol<Library, Function, FuncType, Lock>::operator()(Args&&... args) const {
+        return call(std::forward<Args>(args)...);
+    }
+
+    template<Detail::FixedString Library, Detail::FixedString Function, Callable FuncType, typename Lock>
+    void Symbol<Library, Function, FuncType, Lock>::bind() {
+        // the only place the names are hashed, once per slot and after every unload
+        Detail::BindStaticSlot(Detail::InternName(Library.view()), Detail::InternName(Function.view()),
+            reinterpret_cast<std::atomic<uintptr_t>*>(&slot), reinterpret_cast<uintptr_t>(&Bootstrap::entry),
+            std::is_same_v<Lock, EpochLocked>);
+    }
+
+    template<typename Interface>
+    BoundInterface<Interface>::Scope::Scope(const Detail::InterfaceTable* interface, const bool required) noexcept
+        : table(static_cast<const Interface*>(interface->current.load(std::memory_order_acquire))) {
+        if (required && !this->table) {
+            std::cerr << "invalid dynamic interface call: library has unloaded";
+            std::terminate();
+        }
+    }
+
+    template<typename Interface>
+    const Interface* BoundInterface<Interface>::Scope::operator->() const noexcept {
+        return this->table;
+    }
+
+    template<typename Interface>
+    const Interface& BoundInterface<Interface>::Scope::operator*() const noexcept {
+        return *this->table;
+    }
+
+    template<typename Interface>
+    BoundInterface<Interface>::Scope::operator bool() const noexcept {
+        return this->table != nullptr;
+    }
+
+    template<typename Interface>
+    BoundInterface<Interface>::BoundInterface(Detail::InterfaceTable* interface) noexcept
+        : interface(interface) {}
+
+    template<typename Interface>
+    typename BoundInterface<Interface>::Scope BoundInterface<Interface>::operator->() const {
+        if (this->interface->current.load(std::memory_order_acquire) == nullptr) [[unlikely]] {
+            Detail::RebindInterfaceImpl(this->interface);
+        }
+        return Scope(this->interface, true);
+    }
+
+    template<typename Interface>
+    typename BoundInterface<Interface>::Scope BoundInterface<Interface>::pin() const {
+        if (this->interface->current.load(std::memory_order_acquire) == nullptr) [[unlikely]] {
+            Detail::RebindInterfaceImpl(this->interface);
+        }
+        return Scope(this->interface, false);
+    }
+
+    template<typename Interface>
+    bool BoundInterface<Interface>::available() const {
+        return this->pin().operator bool();
+    }
+
+    template<typename Interface>
+    BoundInterface<Interface> BindInterface(const std::string& lib) {
+        std::vector<Detail::SymbolId> symbols;
+        std::apply([&](const auto&... binding) {
+            (symbols.push_back(Detail::InternName(binding.name)), ...);
+        }, Interface::symbols);
+        return BoundInterface<Interface>(Detail::BindInterfaceImpl(Detail::InternName(lib), std::move(symbols),
+            &Detail::BuildInterface<Interface>, &Detail::DestroyInterface<Interface>));
+    }
 }
 
 #endif //DYNAMICLINK_DYNAMICLINK_IPP
@@ -0,0 +1,50 @@
+//
+// Created by DS on 2025/12/20.
+//
+
+#ifndef DYNAMICLINK_BUNDLE_H
+#define DYNAMICLINK_BUNDLE_H
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Libraries that never touch the disk: every image is copied into a sealed memfd and
+// registered with the path index, dlopen opens it through /proc/self/fd like any file.
+namespace Detail {
+    struct BundleMember {
+        std::string_view name; //< file name without directories
+        std::span<const std::byte> image;
+    };
+
+    // regular files of an uncompressed ustar/GNU tar archive, nullopt when it is malformed
+    std::optional<std::vector<BundleMember>> ReadBundle(std::span<const std::byte> archive);
+
+    // makes `image` loadable under `name`, false when no memfd could be created
+    bool RegisterMemoryLibrary(const std::string& name, std::span<const std::byte> image);
+
+    /**
+     * maps `file` and registers every member as "<prefix>/<member>", or under the bare
+     * member name without a prefix
+     *
+     * @return the registered names in archive order, nullopt when the file can't be read
+     */
+    std::optional<std::vector<std::string>> RegisterBundle(const std::string& file, const std::string& prefix);
+
+    /**
+     * orders registered members so each one is loaded after the members it needs
+     *
+     * The loader binds a DT_NEEDED entry to the first loaded library with that soname, so a
+     * dependency only reaches a member through the member's DT_SONAME. The order is refused,
+     * with the reason on stderr, when a member needs a soname that a library loaded earlier
+     * already provides, a member without that soname, or members that need each other.
+     *
+     * @return the load order, nullopt when refused
+     */
+    std::optional<std::vector<std::string>> BundleLoadOrder(const std::vector<std::string>& names);
+}
+
+#endif //DYNAMICLINK_BUNDLE_H
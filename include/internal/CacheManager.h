@@ -6,9 +6,21 @@
 #define DYNAMICLINK_CACHEMANAGER_H
 
 
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <shared_mutex>
+#include <vector>
 #include "internal//DynamicLinkImpl.h"
+#include "internal//InterfaceTable.h"
+#include "internal//ReloadState.h"
+#include "internal//SymbolResolver.h"
+#include "internal//Trampoline.h"
 
 //Single instance mode class
 namespace Detail {
@@ -18,31 +30,129 @@ namespace Detail {
             static CacheManager manager;
             return manager;
         }
-        void operator()(const std::string&, LHANDLE);
-        void operator()(const std::string& lib, const std::string& func, uintptr_t function);
-        bool containsLibrary(const std::string&) const;
-        bool containsFunction(const std::string& lib, const std::string& func);
-        FunctionDescriptor* getFunctionDescriptor(const std::string& lib, const std::string& func);
-        LHANDLE getLibraryHandle(const std::string&);
-        void unloadLibrary(const std::string&);
-        void reloadLibrary(const std::string&, const std::string&);
-        bool isOutOfDate(const std::string&) const;
-        std::string getNewName(const std::string &);
+        void operator()(LibraryId, LHANDLE);
+        void operator()(LibraryId lib, SymbolId func, uintptr_t function);
+        bool containsLibrary(LibraryId) const;
+        bool containsFunction(LibraryId lib, SymbolId func) const;
+        // invalid handle when the function has not been cached
+        DescriptorHandle getFunctionDescriptor(LibraryId lib, SymbolId func) const;
+        // resolves and caches the function, a miss is remembered until the library is reloaded
+        DescriptorHandle findFunction(LibraryId lib, SymbolId func);
+        LHANDLE getLibraryHandle(LibraryId) const;
+        struct CachedFunction {
+            LibraryId library;
+            SymbolId function;
+            std::uint32_t index; //< descriptor slot
+        };
+        std::vector<CachedFunction> cachedFunctions() const;
+        // exported functions of a loaded library, empty when it is not loaded
+        std::vector<std::string> listFunctions(LibraryId, std::string_view prefix) const;
+        void unloadLibrary(LibraryId);
+        // false when a reload hook of either version failed, the old version stays published
+        bool reloadLibrary(LibraryId, LibraryId);
+        LibraryId getNewName(LibraryId) const;
+        // one table per library name and interface: binding the same pair again returns the
+        // table registered first, the tables live as long as the cache
+        InterfaceTable* registerInterface(std::unique_ptr<InterfaceTable>);
+        // resolve and publish the whole table, false when the library is not loaded
+        // or misses one of the symbols
+        bool attachInterface(InterfaceTable&);
+        // entry of the trampoline for the function, created on first use, the library is never
+        // unmapped afterwards; nullptr when it is not loaded or the function is missing without a fallback
+        void* stablePointer(LibraryId lib, SymbolId func, uintptr_t fallback);
+        // stores the function's address in a caller owned slot that reloads keep rewriting,
+        // an unload sets it to `fallback`; false when the library is not loaded or lacks the function
+        // (a slot bound before only fails while it holds `fallback`). Unless calls through the slot
+        // are `guarded` by the epoch the library is never unmapped afterwards
+        bool bindSlot(LibraryId lib, SymbolId func, std::atomic<uintptr_t>* slot, uintptr_t fallback,
+            bool guarded);
+        // closes retired libraries, binds every interface that can be and prefaults every
+        // loaded image, so a forked child starts without loader work
+        void prepareForFork();
+        // fork handlers: every lock of the cache is held across fork(), the descriptor
+        // and trampoline tables are only written under a shard and need no lock of their own
+        void lockForFork();
+        void unlockAfterFork(bool child);
 
     private:
         CacheManager() = default;
         ~CacheManager();
+        // a slot follows its function through reloads, points at `fallback` while unloaded
+        struct StableEntry {
+            static constexpr std::uint32_t noTrampoline = UINT32_MAX;
+            SymbolId function;
+            std::atomic<uintptr_t>* slot;
+            uintptr_t fallback;
+            std::uint32_t trampoline{noTrampoline}; //< trampoline jumping through `slot`, if any
+            bool pinning{true}; //< calls through it are not epoch guarded, every image it targets stays mapped
+        };
         struct LibraryCache {
+            LHANDLE handle{nullptr};
+            SymbolResolver resolver{};
+            std::unordered_map<SymbolId, DescriptorHandle> functions; //< slots in DescriptorTable
+            std::unordered_set<SymbolId> missing{}; //< looked up and not found, dropped with the library
+            std::vector<InterfaceTable*> interfaces;                  //< bound tables, owned by `interfaceTables`
+            std::vector<StableEntry> trampolines{};
+        };
+        struct RetiredInterface {
+            InterfaceTable::Destroy destroy;
+            const void* table;
+        };
+        // closed by the reclaimer once no call runs below `generation`
+        struct RetiredLibrary {
+            LHANDLE handle;
+            std::vector<RetiredInterface> interfaces{};
+            std::uint64_t generation{0};
+            DynamicLink::ReloadState state{}; //< handed over by copy, released before the close
+        };
+        // the new library of a reload, loaded and resolved before any shard is locked
+        struct PreparedReload {
             LHANDLE handle;
-            std::unordered_map<std::string, FunctionDescriptor> functions;
+            SymbolResolver resolver;
+            std::unordered_map<SymbolId, uintptr_t> addresses{};         //< 0 for a missing symbol
+            std::unordered_map<InterfaceTable*, const void*> interfaces{}; //< built, not yet published
+            DynamicLink::ReloadState handedState{};                        //< copied by the new version
+            LHANDLE previous{nullptr}; //< extra reference keeping the old image open until publish
         };
-        std::unordered_map<std::string, LibraryCache> libraries{};
-        using NewName = std::string; using OldName = std::string;
+        // libraries are spread over independently locked shards by id
+        struct alignas(64) Shard {
+            mutable std::shared_mutex mutex{};
+            std::unordered_map<LibraryId, LibraryCache> libraries{};
+        };
+        static constexpr std::size_t shardCount = 16;
+        std::array<Shard, shardCount> shards{};
+
+        Shard& shardOf(const LibraryId lib) {
+            return this->shards[lib % shardCount];
+        }
+        const Shard& shardOf(const LibraryId lib) const {
+            return this->shards[lib % shardCount];
+        }
+
+        using NewName = LibraryId; using OldName = LibraryId;
         std::unordered_map<OldName, NewName> libraryAlias{};
-        mutable std::shared_mutex mutex{};
-        void doUnloadLibrary(const std::string&);
+        mutable std::shared_mutex aliasMutex{};
+        std::vector<std::unique_ptr<InterfaceTable>> interfaceTables{};
+        std::mutex interfaceMutex{};
+        std::unordered_map<LibraryId, std::vector<StableEntry>> parkedTrampolines{}; //< of unloaded libraries
+        std::mutex trampolineMutex{}; //< taken after a shard mutex
+        std::vector<RetiredLibrary> retiredLibraries{};
+        std::mutex retireMutex{};
+        std::condition_variable_any retireSignal{};
+        std::jthread reclaimer{}; //< started with the first reload, stopped by the destructor
+        void doUnloadLibrary(LibraryId);
+        // nullopt when the old library is gone or the reload protocol refused the new version,
+        // which is closed again
+        std::optional<PreparedReload> prepareReload(LibraryId oldLib, LibraryId newLib);
+        // drops a reload that is never published, the old library is left as it is
+        static void abandonReload(PreparedReload&);
+        void retire(RetiredLibrary);
+        void reclaim(const std::stop_token&);
+        static void closeRetired(const std::vector<RetiredLibrary>&);
+        static const void* resolveInterface(LibraryCache&, const InterfaceTable&);
+        static void retargetSlot(const StableEntry&, uintptr_t address);
     };
 }
 
 
-#endif //DYNAMICLINK_CACHEMANAGER_H
\ No newline at end of file
+#endif //DYNAMICLINK_CACHEMANAGER_H
@@ -0,0 +1,82 @@
+//
+// Created by DS on 2025/12/08.
+//
+
+#ifndef DYNAMICLINK_DESCRIPTORTABLE_H
+#define DYNAMICLINK_DESCRIPTORTABLE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace Detail {
+    // one slot of the descriptor slab, four of them share a cache line
+    struct alignas(16) FunctionDescriptor {
+        std::atomic<uintptr_t> functionPointer{0};
+        std::atomic<std::uint32_t> generation{1}; //< bumped every time the slot is released
+    };
+
+    // generation tagged reference into the slab, a released slot makes every handle to it stale
+    struct DescriptorHandle {
+        static constexpr std::uint32_t invalidIndex = UINT32_MAX;
+        std::uint32_t index{invalidIndex};
+        std::uint32_t generation{0};
+
+        [[nodiscard]] bool valid() const noexcept {
+            return this->index != invalidIndex;
+        }
+    };
+
+    // Slab of descriptors: allocated in fixed chunks, never freed, slots are recycled.
+    // A descriptor survives reloads in place, only unload releases it.
+    class DescriptorTable {
+    public:
+        static constexpr std::uint32_t chunkSize = 4096;
+        static constexpr std::uint32_t chunkCount = 4096;
+
+        static DescriptorTable& instance() {
+            static DescriptorTable table;
+            return table;
+        }
+
+        DescriptorHandle allocate(uintptr_t function);
+        void release(DescriptorHandle handle);
+
+        FunctionDescriptor& at(const std::uint32_t index) const noexcept {
+            return this->chunks[index / chunkSize].load(std::memory_order_acquire)[index % chunkSize];
+        }
+
+        // lock free, 0 when the handle is stale
+        uintptr_t load(const DescriptorHandle handle) const noexcept {
+            if (!handle.valid()) {
+                return 0;
+            }
+            const FunctionDescriptor& descriptor = this->at(handle.index);
+            if (descriptor.generation.load(std::memory_order_acquire) != handle.generation) {
+                return 0;
+            }
+            const uintptr_t function = descriptor.functionPointer.load(std::memory_order_acquire);
+            if (descriptor.generation.load(std::memory_order_acquire) != handle.generation) {
+                return 0; // released while reading
+            }
+            return function;
+        }
+
+    private:
+        DescriptorTable() = default;
+        ~DescriptorTable() = default;
+
+        std::array<std::atomic<FunctionDescriptor*>, chunkCount> chunks{};
+        std::mutex mutex{};
+        std::vector<std::uint32_t> freeList{};
+        std::uint32_t next{0};
+    };
+
+    inline uintptr_t LoadDescriptor(const DescriptorHandle handle) noexcept {
+        return DescriptorTable::instance().load(handle);
+    }
+}
+
+#endif //DYNAMICLINK_DESCRIPTORTABLE_H
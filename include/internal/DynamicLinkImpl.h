@@ -1,36 +1,71 @@
 #ifndef DYNAMICLINK_LIBRARY_H
 #define DYNAMICLINK_LIBRARY_H
 
+#include <atomic>
+#include <chrono>
 #include <format>
 #include <string>
 #include <memory>
-#include <shared_mutex>
+#include <span>
+#include <string_view>
+#include <vector>
 #include "Platforms.h"
 #include "LibraryFile.h"
+#include "DescriptorTable.h"
+#include "Epoch.h"
+#include "HugePages.h"
+#include "LoadOptions.h"
+#include "SymbolTable.h"
+#include "Telemetry.h"
+#include "Trace.h"
 namespace Detail {
-    struct FunctionDescriptor {
-        FunctionDescriptor();
-        explicit FunctionDescriptor(uintptr_t);
-        FunctionDescriptor(const FunctionDescriptor&) noexcept ;
-        FunctionDescriptor& operator=(FunctionDescriptor&&) noexcept ;
-        FunctionDescriptor& operator=(const FunctionDescriptor&) noexcept ;
-        FunctionDescriptor& operator=(uintptr_t);
-
-        uintptr_t functionPointer;
-        std::shared_mutex valid;
-    };
-
-    FunctionDescriptor* GetFunctionImpl(const std::string &lib, const std::string &func);
-    bool DescriptorShouldUpdate(const std::string& libName);
-    std::string GetActualLibraryName(const std::string& oldLib);
+    DescriptorHandle GetFunctionImpl(LibraryId lib, SymbolId func);
+    // lookup without loading, invalid handle when the library is not loaded or has no such symbol
+    DescriptorHandle FindFunctionImpl(LibraryId lib, SymbolId func);
+    // loads the library when needed, invalid handle instead of terminating when either is missing
+    DescriptorHandle TryGetFunctionImpl(LibraryId lib, SymbolId func);
+    LibraryId GetActualLibrary(LibraryId oldLib);
+    // entry of the reload-stable trampoline, loads the library when needed
+    void* GetStablePointerImpl(LibraryId lib, SymbolId func, uintptr_t fallback);
+    // points the static slot of a DynamicLink::Symbol at the function, loads the library when needed
+    void BindStaticSlot(LibraryId lib, SymbolId func, std::atomic<uintptr_t>* slot, uintptr_t bootstrap,
+        bool guarded);
 
     LHANDLE LoadLibraryWithCheck(const std::string& lib);
+    // loads with these options instead of the ones configured for the library
+    LHANDLE LoadLibraryWithCheck(const std::string& lib, const DynamicLink::LoadOptions& options);
+    // nullptr when the library doesn't exist or fails to load
+    LHANDLE TryLoadLibrary(const std::string& lib);
+    LHANDLE OpenLibrary(const std::string& lib, bool required);
+    LHANDLE OpenLibrary(const std::string& lib, bool required, const DynamicLink::LoadOptions& options);
+    // another loader reference to a library that is open, nullptr when none can be taken
+    LHANDLE RetainLibrary(LHANDLE handle);
+    // keeps the image mapped for the rest of the process, whatever closes it later
+    void PinLibrary(LHANDLE handle);
 }
 
 namespace DynamicLink {
     void PreloadLibrary(const std::string& lib);
+    void PreloadLibraryFromMemory(const std::string& lib, std::span<const std::byte> image);
+    std::vector<std::string> PreloadBundle(const std::string& bundle, const std::string& prefix);
     void UnloadLibrary(const std::string& lib);
-    void ReloadLibrary(const std::string& oldLib, const std::string& newLib);
+    bool ReloadLibrary(const std::string& oldLib, const std::string& newLib);
     void PreloadFunction(const std::string& lib, const std::string& func);
+    bool HasFunction(const std::string& lib, const std::string& func);
+    std::vector<std::string> ListFunctions(const std::string& lib, std::string_view prefix);
+    std::string LibraryInstance(const std::string& lib, std::size_t index);
+    std::size_t ThreadShard(std::size_t count);
+    void EnableSymbolCache(const std::string& directory);
+    void UseLoaderCache(bool enable);
+    void PrepareForFork();
+    void UseHugePages(bool enable);
+    void EnablePerfMap(bool enable);
+    void StartTrace();
+    bool StopTrace(const std::string& file);
+    void SetLoadOptions(const std::string& lib, const LoadOptions& options);
+    void SetDefaultLoadOptions(const LoadOptions& options);
+    std::size_t HugePageBytes(const std::string& lib);
+    void WatchLibrary(const std::string& lib, std::chrono::milliseconds debounce);
+    void UnwatchLibrary(const std::string& lib);
 }
 #endif // DYNAMICLINK_LIBRARY_H
@@ -0,0 +1,23 @@
+//
+// Created by DS on 2025/12/11.
+//
+
+#ifndef DYNAMICLINK_ELFFILE_H
+#define DYNAMICLINK_ELFFILE_H
+
+#include <string>
+#include <vector>
+#include "LibraryFile.h"
+
+// Minimal reader for the parts of a shared object the loader cares about,
+// works on the file so nothing has to be dlopen-ed first.
+namespace Detail {
+    // DT_NEEDED entries of the library, empty when the file is not a native ELF object
+    std::vector<std::string> ReadNeededLibraries(const path& library);
+    // DT_SONAME of the library, empty when it has none
+    std::string ReadSoname(const path& library);
+    // asks the kernel to start reading the file into the page cache
+    void PrefetchLibrary(const path& library);
+}
+
+#endif //DYNAMICLINK_ELFFILE_H
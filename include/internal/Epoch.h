@@ -0,0 +1,86 @@
+//
+// Created by DS on 2025/12/02.
+//
+
+#ifndef DYNAMICLINK_EPOCH_H
+#define DYNAMICLINK_EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+
+// Generation/epoch based quiescence for the call path.
+// Readers publish the generation they observed in a thread-owned record, so a
+// call never writes to a shared cache line. Writers (unload/reload) bump the
+// generation after unpublishing a library and wait for every reader still
+// running under an older generation before releasing the old handle.
+namespace Detail {
+    //< bumped on every unload/reload, wrappers compare it against their cached value
+    inline std::atomic<std::uint64_t> libraryGeneration{1};
+
+    struct alignas(64) EpochRecord {
+        std::atomic<std::uint64_t> active{0}; //< generation of the outermost in-flight call, 0 when idle
+        std::uint64_t seen{1};                //< last generation this thread observed
+        std::uint32_t nesting{0};
+        EpochRecord* next{nullptr};
+        std::atomic<bool> used{false};
+    };
+
+    inline thread_local constinit EpochRecord* threadRecord = nullptr;
+    inline bool asymmetricBarrier = false; //< written once before any record is handed out
+
+    EpochRecord* AcquireEpochRecord();
+
+    /**
+     * @brief wait until every call that started before the generation became
+     *        `target` has returned
+     *
+     * @warning must not be called from inside a dynamic function call of this thread
+     *          for the library being released, the own record is skipped
+     */
+    void SynchronizeEpoch(std::uint64_t target);
+
+    // fork handlers: the record list is held across fork(), a child drops the records
+    // of the threads it did not inherit
+    void LockRecordsForFork();
+    void UnlockRecordsAfterFork(bool child);
+
+    // RAII read side section, cheap enough to be taken on every call
+    class EpochGuard {
+    public:
+        EpochGuard() noexcept {
+            EpochRecord* record = threadRecord;
+            if (record == nullptr) [[unlikely]] {
+                record = AcquireEpochRecord();
+            }
+            if (record->nesting++ == 0) {
+                // announce first, only a generation read after the announcement is trusted
+                record->active.store(record->seen, std::memory_order_relaxed);
+                if (asymmetricBarrier) {
+                    std::atomic_signal_fence(std::memory_order_seq_cst);
+                } else {
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                }
+            }
+            this->observed = libraryGeneration.load(std::memory_order_acquire);
+            record->seen = this->observed;
+        }
+
+        ~EpochGuard() {
+            if (EpochRecord* record = threadRecord; --record->nesting == 0) {
+                record->active.store(0, std::memory_order_release);
+            }
+        }
+
+        EpochGuard(const EpochGuard&) = delete;
+        EpochGuard& operator=(const EpochGuard&) = delete;
+
+        [[nodiscard]] std::uint64_t generation() const noexcept {
+            return this->observed;
+        }
+
+    private:
+        std::uint64_t observed;
+    };
+}
+
+#endif //DYNAMICLINK_EPOCH_H
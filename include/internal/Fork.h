@@ -0,0 +1,34 @@
+//
+// Created by DS on 2025/12/19.
+//
+
+#ifndef DYNAMICLINK_FORK_H
+#define DYNAMICLINK_FORK_H
+
+#include <memory>
+#include <shared_mutex>
+
+// pthread_atfork handlers over the registry: the parent takes every registry lock before
+// fork() so neither process inherits one mid-operation. The parent releases them afterwards,
+// the child starts over with fresh locks.
+namespace Detail {
+    // installs the handlers once, later calls do nothing
+    void InstallForkHandlers();
+
+    // held shared around every call into the dynamic loader and exclusively across fork():
+    // the loader's own locks are not reset in a child, one taken by another thread stays taken
+    inline std::shared_mutex loaderMutex{};
+
+    // a rwlock records its writer's thread id, which the child's thread doesn't have, so
+    // an inherited lock can't be unlocked there and is constructed again over the old one
+    template<typename Mutex>
+    void ReleaseAfterFork(Mutex& mutex, const bool child) {
+        if (child) {
+            std::construct_at(&mutex);
+        } else {
+            mutex.unlock();
+        }
+    }
+}
+
+#endif //DYNAMICLINK_FORK_H
@@ -0,0 +1,25 @@
+//
+// Created by DS on 2025/12/15.
+//
+
+#ifndef DYNAMICLINK_HUGEPAGES_H
+#define DYNAMICLINK_HUGEPAGES_H
+
+#include <cstddef>
+#include "Platforms.h"
+
+namespace Detail {
+    /**
+     * copies the 2 MiB aligned part of every executable PT_LOAD segment into anonymous
+     * memory backed by transparent huge pages and moves it over the original range
+     *
+     * @return bytes remapped, 0 when THP is unavailable or no segment spans a whole huge page
+     * @warning only while nothing executes inside the image, i.e. before it is published
+     */
+    std::size_t RemapTextToHugePages(LHANDLE handle);
+
+    // text of the image currently backed by huge pages, read from /proc/self/smaps
+    std::size_t HugePageTextBytes(LHANDLE handle);
+}
+
+#endif //DYNAMICLINK_HUGEPAGES_H
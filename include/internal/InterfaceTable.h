@@ -0,0 +1,54 @@
+//
+// Created by DS on 2025/12/10.
+//
+
+#ifndef DYNAMICLINK_INTERFACETABLE_H
+#define DYNAMICLINK_INTERFACETABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "SymbolTable.h"
+
+namespace Detail {
+    // Type erased state behind a DynamicLink::BoundInterface. `current` points to a
+    // fully resolved interface struct, reload publishes a new one in a single store.
+    struct InterfaceTable {
+        using Build = const void* (*)(const uintptr_t* addresses);
+        using Destroy = void (*)(const void* table);
+
+        LibraryId name;                 //< library it was bound under, follows no reload
+        std::atomic<LibraryId> library;
+        std::vector<SymbolId> symbols;
+        Build build;
+        Destroy destroy;
+        std::atomic<const void*> current{nullptr}; //< nullptr while the library is not loaded
+    };
+
+    // resolves every symbol in one locked pass, loads the library when needed
+    InterfaceTable* BindInterfaceImpl(LibraryId lib, std::vector<SymbolId> symbols,
+        InterfaceTable::Build build, InterfaceTable::Destroy destroy);
+    // re-attaches a table whose library was unloaded, false when it is still unavailable
+    bool RebindInterfaceImpl(InterfaceTable* table);
+
+    // fills an Interface from addresses ordered like Interface::symbols
+    template<typename Interface>
+    const void* BuildInterface(const uintptr_t* addresses) {
+        auto* table = new Interface{};
+        std::size_t index = 0;
+        std::apply([&](const auto&... binding) {
+            ((table->*binding.member = reinterpret_cast<std::remove_reference_t<decltype(table->*binding.member)>>(
+                addresses[index++])), ...);
+        }, Interface::symbols);
+        return table;
+    }
+
+    template<typename Interface>
+    void DestroyInterface(const void* table) {
+        delete static_cast<const Interface*>(table);
+    }
+}
+
+#endif //DYNAMICLINK_INTERFACETABLE_H
@@ -9,14 +9,27 @@
 #include <string>
 #include <string_view>
 #include <optional>
+#include <utility>
 
 namespace Detail {
     using path = std::filesystem::path;
+    // "libfoo.so#2" names the isolated instance 2 of libfoo.so
+    inline constexpr char instanceSeparator = '#';
+    // library name without the instance suffix, and whether there was one
+    std::pair<std::string, bool> SplitInstance(const std::string& name);
     bool IsFullName(std::string_view name);
     std::string GetFullName(const std::string&);
     void AddSearchPath(const std::string&);
+    // also resolve the sonames listed in /etc/ld.so.cache, after every search path
+    void UseLoaderCache(bool enable);
+    // in-memory lookup over "./", SYSTEM_PATH and the search paths, in that order
     std::optional<path> GetLibraryPath(const std::string& name);
     bool IsValidPath(const std::string &name);
+    // `fullName` resolves to the memfd from now on, ahead of any file; replaces an earlier image
+    void AddMemoryLibrary(const std::string& fullName, int file);
+    // fork handlers, the path index is held across fork()
+    void LockIndexForFork();
+    void UnlockIndexAfterFork(bool child);
 } // Detail
 
 #endif //DYNAMICLINK_LIBRARYFILE_H
\ No newline at end of file
@@ -0,0 +1,63 @@
+//
+// Created by DS on 2025/12/12.
+//
+
+#ifndef DYNAMICLINK_LIBRARYWATCHER_H
+#define DYNAMICLINK_LIBRARYWATCHER_H
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "LibraryFile.h"
+#include "SymbolTable.h"
+
+// Reloads watched libraries when their file is rebuilt. Every new build is copied to a
+// unique shadow path first, dlopen would hand back the already loaded image for the
+// original path, and reloaded through the alias chain like ReloadLibrary.
+namespace Detail {
+    class LibraryWatcher {
+    public:
+        static LibraryWatcher& instance() {
+            static LibraryWatcher watcher;
+            return watcher;
+        }
+        void watch(LibraryId lib, std::chrono::milliseconds debounce);
+        void unwatch(LibraryId lib);
+        // fork handlers, a child stops watching: the thread, the inotify queue and the
+        // shadow copies stay with the parent
+        void lockForFork();
+        void unlockAfterFork(bool child);
+
+    private:
+        LibraryWatcher();
+        ~LibraryWatcher();
+        using Clock = std::chrono::steady_clock;
+        struct WatchedLibrary {
+            LibraryId library;                 //< name the user watches, the alias chain starts here
+            path source;                       //< file rebuilt by the user
+            int directory;                     //< inotify watch of the source's directory
+            std::chrono::milliseconds debounce;
+            std::optional<Clock::time_point> due{}; //< reload time after the last write
+            path shadow{};                     //< loaded copy, empty before the first reload
+        };
+        void run(const std::stop_token&);
+        // unique copy of `source` to load, under the mutex
+        path shadowOf(const path& source);
+        // runs without the mutex, false when the library isn't loaded or the reload was refused
+        bool reload(LibraryId lib, const path& source, const path& shadow);
+
+        std::vector<WatchedLibrary> libraries{};
+        std::unordered_map<int, path> directories{}; //< inotify watch -> directory
+        std::mutex mutex{};
+        int notify{-1};
+        std::uint32_t shadowCount{0};
+        path shadowDirectory{};
+        std::jthread thread{}; //< started with the first watched library
+    };
+}
+
+#endif //DYNAMICLINK_LIBRARYWATCHER_H
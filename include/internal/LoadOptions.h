@@ -0,0 +1,64 @@
+//
+// Created by DS on 2025/12/16.
+//
+
+#ifndef DYNAMICLINK_LOADOPTIONS_H
+#define DYNAMICLINK_LOADOPTIONS_H
+
+#include <cstdint>
+#include <vector>
+#include "Platforms.h"
+#include "SymbolTable.h"
+
+namespace DynamicLink {
+    enum class Binding {
+        Lazy, //< RTLD_LAZY, imports are bound on their first call
+        Now   //< RTLD_NOW, every import is bound while loading
+    };
+
+    enum class Visibility {
+        Local, //< RTLD_LOCAL
+        Global //< RTLD_GLOBAL, the symbols serve libraries loaded later
+    };
+
+    /**
+     * @brief how a library is loaded, see SetLoadOptions
+     */
+    struct LoadOptions {
+        Binding binding{Binding::Lazy};
+        Visibility visibility{Visibility::Local};
+        bool noDelete{false};  //< RTLD_NODELETE, dlclose keeps the image mapped
+        bool deepBind{false};  //< RTLD_DEEPBIND, prefer the library's own symbols over global ones
+        bool prewarm{false};   //< prefault every mapped segment before the library is published
+        bool hugePages{false}; //< move the code onto transparent huge pages, see UseHugePages
+    };
+}
+
+namespace Detail {
+    // options registered for the library, the defaults otherwise
+    DynamicLink::LoadOptions GetLoadOptions(LibraryId lib);
+    void SetLoadOptions(LibraryId lib, const DynamicLink::LoadOptions& options);
+    void SetDefaultLoadOptions(const DynamicLink::LoadOptions& options);
+    DynamicLink::LoadOptions GetDefaultLoadOptions();
+    // a reloaded library keeps the options of its predecessor unless it has its own
+    void InheritLoadOptions(LibraryId from, LibraryId to);
+    // libraries that have options of their own
+    std::vector<LibraryId> ConfiguredLibraries();
+    // fork handlers, the options are held across fork()
+    void LockOptionsForFork();
+    void UnlockOptionsAfterFork(bool child);
+    // dlopen flags, 0 on Windows
+    int LoaderFlags(const DynamicLink::LoadOptions& options);
+
+    struct ImageSegment {
+        uintptr_t begin;
+        uintptr_t end;
+        bool executable;
+    };
+    // PT_LOAD segments of a loaded image, empty when they can't be found
+    std::vector<ImageSegment> ImageSegments(LHANDLE handle);
+    // faults the pages of every segment in, MADV_POPULATE_READ or MADV_WILLNEED where unavailable
+    void PrefaultImage(LHANDLE handle);
+}
+
+#endif //DYNAMICLINK_LOADOPTIONS_H
@@ -5,13 +5,16 @@
 #ifndef DYNAMICLINK_PLATFORMS_H
 #define DYNAMICLINK_PLATFORMS_H
 
+#include <string>
+
 #ifdef _WIN32
 
 #include <windows.h>
-#define LOAD_LIB(x) LoadLibrary(x)
+#define LOAD_LIB(x, flags) LoadLibrary(x)
 #define UNLOAD_LIB(x) FreeLibrary(x)
 #define GET_FUNC(x, y) reinterpret_cast<uintptr_t>(GetProcAddress(x, y))
-#define LHANDLE HMODULE
+#define LOAD_LIB_ISOLATED(x, flags) nullptr // no linker namespaces
+using LHANDLE = HMODULE;
 #define SUFFIX ".lib"
 #define SYSTEM_PATH "C:/Windows/System32/"
 
@@ -44,14 +47,15 @@ inline std::string GetWindowsError() {
 #elif defined(__linux__)
 
 #include <dlfcn.h>
-int GetFlag();
-void SetFlag(int);
-#define LOAD_LIB(x) dlopen(x, GetFlag())
+#define LOAD_LIB(x, flags) dlopen(x, flags)
+// a private copy in a new linker namespace, RTLD_GLOBAL is rejected by dlmopen
+#define LOAD_LIB_ISOLATED(x, flags) dlmopen(LM_ID_NEWLM, x, (flags) & ~RTLD_GLOBAL)
 #define UNLOAD_LIB(x) dlclose(x)
 #define GET_FUNC(x, y) reinterpret_cast<uintptr_t>(dlsym(x, y))
-#define LHANDLE void*
+using LHANDLE = void*;
 #define PREFIX "lib"
 #define SUFFIX ".so"
+#define SYSTEM_PATH "/usr/lib/"
 
 
 //Get system error
@@ -0,0 +1,58 @@
+//
+// Created by DS on 2025/12/21.
+//
+
+#ifndef DYNAMICLINK_RELOADSTATE_H
+#define DYNAMICLINK_RELOADSTATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "SymbolResolver.h"
+
+namespace DynamicLink {
+    /**
+     * @brief state handed from the old to the new version of a library during ReloadLibrary
+     *
+     * A library takes part by exporting any of these C functions, each returning 0 on success:
+     *
+     * - `int warmup()` fills the new version's caches before any call reaches it
+     * - `int export_state(DynamicLink::ReloadState*)` fills in the state of the old version
+     * - `int import_state(DynamicLink::ReloadState*)` takes it over in the new version
+     *
+     * Warm-up runs first, the handoff is the last step before the new version is published, so
+     * nothing can fail once it owns the state. The state only moves when the old version exports
+     * it and the new one imports it. The old version keeps serving until publish: exporting must
+     * leave its state intact, and a failing import must not keep `data`. An importer that
+     * understands `version` can adopt `data` as is and clear `release`, otherwise it copies what
+     * it needs and `release` is called on the old version's behalf once that version is retired.
+     */
+    struct ReloadState {
+        std::uint32_t version{0}; //< layout of `data`, chosen by the library
+        void* data{nullptr};      //< blob or arena, must outlive the old version when adopted
+        std::size_t size{0};
+        void (*release)(void* data, std::size_t size){nullptr}; //< frees `data`, optional
+    };
+}
+
+namespace Detail {
+    using ExportState = int (*)(DynamicLink::ReloadState*);
+    using ImportState = int (*)(DynamicLink::ReloadState*);
+    using Warmup = int (*)();
+
+    inline constexpr std::string_view exportStateHook = "export_state";
+    inline constexpr std::string_view importStateHook = "import_state";
+    inline constexpr std::string_view warmupHook = "warmup";
+
+    /**
+     * runs the reload protocol between two loaded versions before the new one is published:
+     * the new version's warm-up, then the state handoff when both sides take part
+     *
+     * @param handed receives the state the new version copied, released with the old version
+     * @return false when a hook failed, the old version then stays in place untouched
+     */
+    bool HandOverState(const SymbolResolver& from, const SymbolResolver& to, std::string_view library,
+        DynamicLink::ReloadState& handed);
+}
+
+#endif //DYNAMICLINK_RELOADSTATE_H
@@ -0,0 +1,47 @@
+//
+// Created by DS on 2025/12/18.
+//
+
+#ifndef DYNAMICLINK_STATICSYMBOL_H
+#define DYNAMICLINK_STATICSYMBOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Compile-time pieces of DynamicLink::Symbol, names are template arguments and the
+// resolved address lives in one static slot per symbol.
+namespace Detail {
+    // a string literal usable as a template argument
+    template<std::size_t N>
+    struct FixedString {
+        char value[N]{};
+
+        constexpr FixedString(const char (&text)[N]) noexcept {
+            std::copy_n(text, N, this->value);
+        }
+
+        [[nodiscard]] constexpr std::string_view view() const noexcept {
+            return {this->value, N - 1};
+        }
+    };
+
+    // first target of a symbol's slot: binds the slot, then calls through it
+    template<typename Owner, typename Signature>
+    struct SlotBootstrap {
+        // only C variadic signatures are left for the primary template
+        static_assert(!std::is_function_v<Signature>, "C variadic functions can't be bound to a static symbol");
+    };
+
+    template<typename Owner, typename R, typename... Params>
+    struct SlotBootstrap<Owner, R(Params...)> {
+        static R entry(Params... params) {
+            Owner::bind();
+            return Owner::slot.load(std::memory_order_acquire)(std::forward<Params>(params)...);
+        }
+    };
+}
+
+#endif //DYNAMICLINK_STATICSYMBOL_H
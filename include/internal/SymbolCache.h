@@ -0,0 +1,57 @@
+//
+// Created by DS on 2025/12/14.
+//
+
+#ifndef DYNAMICLINK_SYMBOLCACHE_H
+#define DYNAMICLINK_SYMBOLCACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "LibraryFile.h"
+
+// Symbol offsets of a library build kept on disk between runs. A file is keyed by the
+// library path and validated against the build-id (size and mtime without one), a warm
+// start maps it and turns names into `base + offset` without touching the symbol table.
+namespace Detail {
+    // empty path disables the cache, already opened caches keep their directory
+    void SetSymbolCacheDirectory(const path& directory);
+
+    class SymbolCache {
+    public:
+        // nullptr when the cache is disabled
+        static std::shared_ptr<SymbolCache> Open(const path& library, std::string identity);
+        ~SymbolCache();
+        SymbolCache(const SymbolCache&) = delete;
+        SymbolCache& operator=(const SymbolCache&) = delete;
+
+        // offset from the load base, nullopt when this build has no entry yet
+        std::optional<uintptr_t> find(std::string_view name) const;
+        void record(std::string_view name, uintptr_t offset);
+
+        // fork handlers, the directory and every open cache are held across fork()
+        static void LockAllForFork();
+        static void UnlockAllAfterFork(bool child);
+
+    private:
+        SymbolCache(path file, std::string identity);
+        // writes the merged entries next to the file, then renames it over
+        void flush();
+        void map();
+        void unmap();
+
+        path file;
+        std::string identity;                 //< build-id or size/mtime of the library
+        const unsigned char* mapped{nullptr}; //< valid cache file of the same build, read only until destruction
+        std::size_t mappedSize{0};
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, uintptr_t> recorded; //< resolved since the file was mapped
+        bool dirty{false};
+    };
+}
+
+#endif //DYNAMICLINK_SYMBOLCACHE_H
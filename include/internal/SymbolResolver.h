@@ -0,0 +1,60 @@
+//
+// Created by DS on 2025/12/13.
+//
+
+#ifndef DYNAMICLINK_SYMBOLRESOLVER_H
+#define DYNAMICLINK_SYMBOLRESOLVER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Platforms.h"
+#include "SymbolCache.h"
+#ifdef __linux__
+#include <link.h>
+#endif
+
+namespace Detail {
+    struct ExportedFunction {
+        std::string name;
+        uintptr_t address;
+        std::size_t size;
+    };
+
+    // Looks exported symbols up in the loaded image itself through its .gnu.hash (or
+    // .hash) and .dynsym, without dlsym's scope walk and loader lock. Symbols the
+    // image doesn't define itself, ifuncs and TLS still go through GET_FUNC. With a
+    // symbol cache directory set, offsets found once are reused by the next run.
+    class SymbolResolver {
+    public:
+        SymbolResolver() = default;
+        explicit SymbolResolver(LHANDLE handle);
+
+        uintptr_t operator()(const char* name) const;
+        // defined function symbols starting with `prefix`, empty when the image can't be read
+        std::vector<std::string> functions(std::string_view prefix) const;
+        // address and size of every defined function, for profiler symbol maps
+        std::vector<ExportedFunction> exports() const;
+
+    private:
+        LHANDLE handle{nullptr};
+#ifdef __linux__
+        // index of the definition of `name` in .dynsym, 0 when the image has none
+        std::uint32_t find(const char* name) const;
+        std::uint32_t symbolCount() const;
+        bool exported(std::uint32_t index) const;
+
+        uintptr_t base{0};
+        const ElfW(Sym)* symbols{nullptr};
+        const char* strings{nullptr};
+        const std::uint16_t* versions{nullptr}; //< DT_VERSYM, optional
+        const std::uint32_t* gnuHash{nullptr};
+        const std::uint32_t* sysvHash{nullptr};
+        std::shared_ptr<SymbolCache> persistent{}; //< on-disk offsets of this build, optional
+#endif
+    };
+}
+
+#endif //DYNAMICLINK_SYMBOLRESOLVER_H
@@ -0,0 +1,28 @@
+//
+// Created by DS on 2025/12/06.
+//
+
+#ifndef DYNAMICLINK_SYMBOLTABLE_H
+#define DYNAMICLINK_SYMBOLTABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Library and function names are interned once into compact ids, the cache and
+// the wrappers only pass ids around after that. Ids are never recycled.
+namespace Detail {
+    using NameId = std::uint32_t;
+    using LibraryId = NameId;
+    using SymbolId = NameId;
+
+    NameId InternName(std::string_view name);
+    // the reference stays valid for the whole process
+    const std::string& NameOf(NameId id);
+
+    // fork handlers, every shard is held across fork()
+    void LockNamesForFork();
+    void UnlockNamesAfterFork(bool child);
+}
+
+#endif //DYNAMICLINK_SYMBOLTABLE_H
@@ -0,0 +1,209 @@
+//
+// Created by DS on 2025/12/15.
+//
+
+#ifndef DYNAMICLINK_TELEMETRY_H
+#define DYNAMICLINK_TELEMETRY_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include "DescriptorTable.h"
+
+// Optional call/loader instrumentation, enabled with DYNAMICLINK_TELEMETRY.
+// Every thread counts into its own record (single writer, relaxed stores), Stats()
+// sums the records on demand. Disabled, the probes are empty and compile away.
+namespace Detail {
+#ifdef DYNAMICLINK_TELEMETRY
+    inline constexpr bool telemetryEnabled = true;
+#else
+    inline constexpr bool telemetryEnabled = false;
+#endif
+#ifndef DYNAMICLINK_TELEMETRY_SAMPLE
+#define DYNAMICLINK_TELEMETRY_SAMPLE 64
+#endif
+    //< one call out of this many is timed, calls and fallbacks are always counted
+    inline constexpr std::uint32_t telemetrySampleInterval = DYNAMICLINK_TELEMETRY_SAMPLE;
+    static_assert(std::has_single_bit(telemetrySampleInterval), "DYNAMICLINK_TELEMETRY_SAMPLE must be a power of two");
+
+    inline constexpr std::size_t histogramBuckets = 32;
+
+    // only the owning thread writes, so a plain load/store pair replaces a locked add
+    inline void Bump(std::atomic<std::uint64_t>& counter, const std::uint64_t amount = 1) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // bucket i counts durations of [2^(i-1), 2^i) ns, the last one everything above
+    struct TelemetryHistogram {
+        std::array<std::atomic<std::uint64_t>, histogramBuckets> buckets{};
+
+        void add(const std::uint64_t nanoseconds) noexcept {
+            Bump(this->buckets[std::min<std::size_t>(std::bit_width(nanoseconds), histogramBuckets - 1)]);
+        }
+    };
+
+    struct FunctionCounters {
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> fallbacks{0};
+        TelemetryHistogram latency{};
+    };
+
+    enum class Operation : std::uint8_t {
+        Resolve,       //< symbol lookup on a cache miss
+        Load,          //< LoadLibraryWithCheck
+        Reload,        //< whole ReloadLibrary
+        ReloadPublish, //< part of a reload holding the shard locks
+        LockWait,      //< waiting for an exclusive shard lock
+        Count
+    };
+
+    struct OperationCounters {
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> total{0};
+        std::atomic<std::uint64_t> max{0};
+        TelemetryHistogram latency{};
+    };
+
+    // counters of one thread, descriptor indexes map into lazily allocated blocks
+    struct alignas(64) TelemetryRecord {
+        static constexpr std::uint32_t blockSize = 256;
+        using Block = std::array<FunctionCounters, blockSize>;
+        using Directory = std::array<std::atomic<Block*>, blockSize>;
+        static constexpr std::uint32_t directoryCount =
+            DescriptorTable::chunkSize * DescriptorTable::chunkCount / blockSize / blockSize;
+
+        std::array<std::atomic<Directory*>, directoryCount> directories{};
+        std::array<OperationCounters, static_cast<std::size_t>(Operation::Count)> operations{};
+        std::atomic<std::uint64_t> fallbacks{0}; //< including calls whose function is gone
+        std::uint32_t sampleTick{0};
+        TelemetryRecord* next{nullptr};
+        std::atomic<bool> used{false};
+    };
+
+    inline thread_local constinit TelemetryRecord* telemetryRecord = nullptr;
+
+    TelemetryRecord* AcquireTelemetryRecord();
+    // allocates the block of `index` in the calling thread's record
+    FunctionCounters& AllocateCounters(TelemetryRecord& record, std::uint32_t index);
+    // a recycled descriptor slot starts counting from zero again
+    void ResetFunctionTelemetry(std::uint32_t index);
+    // fork handlers, the record list is held across fork()
+    void LockTelemetryForFork();
+    void UnlockTelemetryAfterFork(bool child);
+
+    inline TelemetryRecord& ThreadTelemetry() noexcept {
+        TelemetryRecord* record = telemetryRecord;
+        if (record == nullptr) [[unlikely]] {
+            record = AcquireTelemetryRecord();
+        }
+        return *record;
+    }
+
+    inline FunctionCounters& CountersOf(TelemetryRecord& record, const std::uint32_t index) noexcept {
+        constexpr auto blockSize = TelemetryRecord::blockSize;
+        if (const auto* directory = record.directories[index / blockSize / blockSize].load(std::memory_order_relaxed)) [[likely]] {
+            if (auto* block = (*directory)[index / blockSize % blockSize].load(std::memory_order_relaxed)) [[likely]] {
+                return (*block)[index % blockSize];
+            }
+        }
+        return AllocateCounters(record, index);
+    }
+
+    inline std::uint64_t TelemetryNow() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+#ifdef DYNAMICLINK_TELEMETRY
+    // counts one dynamic call, times it when sampled
+    class CallProbe {
+    public:
+        explicit CallProbe(const std::uint32_t index) noexcept {
+            if (index == DescriptorHandle::invalidIndex) [[unlikely]] {
+                return;
+            }
+            TelemetryRecord& record = ThreadTelemetry();
+            this->counters = &CountersOf(record, index);
+            Bump(this->counters->calls);
+            if ((record.sampleTick++ & (telemetrySampleInterval - 1)) == 0) {
+                this->start = TelemetryNow();
+            }
+        }
+        ~CallProbe() {
+            if (this->start != 0) {
+                this->counters->latency.add(TelemetryNow() - this->start);
+            }
+        }
+        CallProbe(const CallProbe&) = delete;
+        CallProbe& operator=(const CallProbe&) = delete;
+
+    private:
+        FunctionCounters* counters{nullptr};
+        std::uint64_t start{0};
+    };
+
+    // times a loader operation for its whole scope
+    class OperationTimer {
+    public:
+        explicit OperationTimer(const Operation operation) noexcept
+            : operation(operation), start(TelemetryNow()) {}
+        ~OperationTimer() {
+            OperationCounters& counters = ThreadTelemetry().operations[static_cast<std::size_t>(this->operation)];
+            const std::uint64_t elapsed = TelemetryNow() - this->start;
+            Bump(counters.count);
+            Bump(counters.total, elapsed);
+            if (elapsed > counters.max.load(std::memory_order_relaxed)) {
+                counters.max.store(elapsed, std::memory_order_relaxed);
+            }
+            counters.latency.add(elapsed);
+        }
+        OperationTimer(const OperationTimer&) = delete;
+        OperationTimer& operator=(const OperationTimer&) = delete;
+
+    private:
+        Operation operation;
+        std::uint64_t start;
+    };
+
+    // counts a run of calls made through a pinned scope, none of them is timed
+    inline void RecordCalls(const std::uint32_t index, const std::uint64_t calls) noexcept {
+        if (index != DescriptorHandle::invalidIndex && calls != 0) {
+            Bump(CountersOf(ThreadTelemetry(), index).calls, calls);
+        }
+    }
+
+    inline void RecordFallback(const std::uint32_t index) noexcept {
+        TelemetryRecord& record = ThreadTelemetry();
+        Bump(record.fallbacks);
+        if (index != DescriptorHandle::invalidIndex) {
+            Bump(CountersOf(record, index).fallbacks);
+        }
+    }
+#else
+    class CallProbe {
+    public:
+        explicit CallProbe(std::uint32_t) noexcept {}
+    };
+
+    class OperationTimer {
+    public:
+        explicit OperationTimer(Operation) noexcept {}
+    };
+
+    inline void RecordCalls(std::uint32_t, std::uint64_t) noexcept {}
+
+    inline void RecordFallback(std::uint32_t) noexcept {}
+#endif
+
+    // exclusive lock whose wait is reported as Operation::LockWait
+    template<typename Lock>
+    void LockTimed(Lock& lock) {
+        [[maybe_unused]] const OperationTimer timer(Operation::LockWait);
+        lock.lock();
+    }
+}
+
+#endif //DYNAMICLINK_TELEMETRY_H
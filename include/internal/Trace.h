@@ -0,0 +1,62 @@
+//
+// Created by DS on 2025/12/17.
+//
+
+#ifndef DYNAMICLINK_TRACE_H
+#define DYNAMICLINK_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "SymbolResolver.h"
+#include "Telemetry.h"
+
+// Runtime switchable profiler hooks: a Chrome trace-event timeline of the loader phases
+// and a perf map (/tmp/perf-<pid>.map) naming code perf can't attribute on its own.
+// Both only cover loader work, never the call path.
+namespace Detail {
+    inline std::atomic<bool> tracing{false};
+
+    void StartTrace();
+    // stops recording and writes the timeline as JSON, false when the file can't be written
+    bool StopTrace(const std::string& file);
+    void RecordTraceEvent(const char* name, std::string_view subject, std::uint64_t start, std::uint64_t end);
+
+    // one loader phase on the timeline, a relaxed load while no trace is recorded
+    class TraceSpan {
+    public:
+        // `subject` (usually an interned name) must outlive the span
+        TraceSpan(const char* name, const std::string_view subject) noexcept {
+            if (tracing.load(std::memory_order_relaxed)) [[unlikely]] {
+                this->name = name;
+                this->subject = subject;
+                this->start = TelemetryNow();
+            }
+        }
+        ~TraceSpan() {
+            if (this->name != nullptr) [[unlikely]] {
+                RecordTraceEvent(this->name, this->subject, this->start, TelemetryNow());
+            }
+        }
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+    private:
+        const char* name{nullptr};
+        std::string_view subject{};
+        std::uint64_t start{0};
+    };
+
+    void SetPerfMap(bool enable);
+    bool PerfMapEnabled();
+    // appends one "address size name [library]" line per function
+    void WritePerfMap(const std::vector<ExportedFunction>& functions, std::string_view library);
+    // fork handlers, the timeline and the perf map are held across fork(); a child writes
+    // its own map, starting with what the parent had written
+    void LockTraceForFork();
+    void UnlockTraceAfterFork(bool child);
+}
+
+#endif //DYNAMICLINK_TRACE_H
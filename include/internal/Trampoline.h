@@ -0,0 +1,50 @@
+//
+// Created by DS on 2025/12/14.
+//
+
+#ifndef DYNAMICLINK_TRAMPOLINE_H
+#define DYNAMICLINK_TRAMPOLINE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace Detail {
+    // Process lifetime call stubs, comparable to PLT entries. Every stub is an indirect
+    // jump through its own slot, rewriting the slot redirects all callers at once.
+    // A block is one executable code page followed by one writable slot page, entry i
+    // of the code page jumps through slot i, so every code page holds the same bytes.
+    class TrampolineTable {
+    public:
+        static constexpr std::size_t entrySize = 8;
+        static constexpr std::uint32_t blockCount = 1024;
+
+        static TrampolineTable& instance() {
+            static TrampolineTable table;
+            return table;
+        }
+
+        // never released, terminates on platforms without trampoline support
+        std::uint32_t allocate(uintptr_t target);
+        void* entry(std::uint32_t index) const noexcept;
+        // the word the entry jumps through
+        std::atomic<uintptr_t>& slot(std::uint32_t index) const noexcept;
+
+    private:
+        TrampolineTable() = default;
+        ~TrampolineTable() = default;
+
+        std::byte* block(std::uint32_t index) const noexcept;
+
+        std::array<std::atomic<std::byte*>, blockCount> blocks{};
+        std::mutex mutex{};
+        std::uint32_t next{0};
+    };
+
+    // target of a stable pointer whose library is gone and which has no fallback
+    [[noreturn]] void MissingStableTarget();
+}
+
+#endif //DYNAMICLINK_TRAMPOLINE_H
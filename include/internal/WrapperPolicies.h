@@ -0,0 +1,217 @@
+//
+// Created by DS on 2025/12/16.
+//
+
+#ifndef DYNAMICLINK_WRAPPERPOLICIES_H
+#define DYNAMICLINK_WRAPPERPOLICIES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "Epoch.h"
+
+// Policy tags of DynamicLink::FunctionWrapper and the state each of them adds.
+namespace DynamicLink {
+    //< checking: every call validates the cached pointer against the library generation
+    struct CheckAlways {};
+    //< checking: the cached pointer is called as is, the caller keeps the library loaded
+    struct CheckNever {};
+    //< checking: switched at runtime through setCheck, the historical behavior
+    struct CheckRuntime {};
+
+    //< fallback: none, a call without a function is fatal
+    struct NoFallback {};
+    //< fallback: any callable in a std::function
+    struct FunctionFallback {};
+    //< fallback: callables up to `Capacity` bytes stored in the wrapper, no allocation
+    template<std::size_t Capacity = 2 * sizeof(void*)>
+    struct InlineFallback {};
+
+    //< locking: the call announces itself in the thread's epoch record, unload/reload
+    // wait for it before closing the library
+    struct EpochLocked {};
+    //< locking: the generation is only compared, the caller makes sure no unload/reload
+    // runs concurrently with a call
+    struct Unlocked {};
+}
+
+namespace Detail {
+    template<typename FuncType>
+    struct FunctionTraits;
+
+    template<typename R, typename... Params>
+    struct FunctionTraits<R(Params...)> {
+        using Return = R;
+        using Signature = R(Params...); //< without noexcept
+    };
+
+    template<typename R, typename... Params>
+    struct FunctionTraits<R(Params...) noexcept> : FunctionTraits<R(Params...)> {};
+
+    template<typename R, typename... Params>
+    struct FunctionTraits<R(Params..., ...)> {
+        using Return = R;
+        using Signature = R(Params..., ...);
+    };
+
+    template<typename R, typename... Params>
+    struct FunctionTraits<R(Params..., ...) noexcept> : FunctionTraits<R(Params..., ...)> {};
+
+    template<typename Check>
+    struct CheckState {};
+
+    template<>
+    struct CheckState<DynamicLink::CheckRuntime> {
+        bool enabled{true};
+    };
+
+    // read side of the locking policy, `generation()` is what the call is checked against
+    template<typename Lock>
+    struct LockScope;
+
+    template<>
+    struct LockScope<DynamicLink::EpochLocked> : EpochGuard {};
+
+    template<>
+    struct LockScope<DynamicLink::Unlocked> {
+        [[nodiscard]] std::uint64_t generation() const noexcept {
+            return libraryGeneration.load(std::memory_order_acquire);
+        }
+    };
+
+    // whether F can be called with the elements of a std::tuple, for batched calls
+    template<typename F, typename R, typename Tuple>
+    struct TupleInvocable : std::false_type {};
+
+    template<typename F, typename R, typename... Ts>
+    struct TupleInvocable<F, R, std::tuple<Ts...>> : std::bool_constant<std::is_invocable_r_v<R, F, const Ts&...>> {};
+
+    [[noreturn]] inline void MissingFallback() {
+        std::cerr << "invalid dynamic function call: library has unloaded with no fallback";
+        std::terminate();
+    }
+
+    template<typename Fallback, typename FuncType>
+    class FallbackStorage;
+
+    template<typename R, typename... Params>
+    class FallbackStorage<DynamicLink::NoFallback, R(Params...)> {
+    public:
+        static constexpr bool enabled = false;
+
+        [[noreturn]] R operator()(Params...) {
+            MissingFallback();
+        }
+    };
+
+    // C variadic functions can't be wrapped by another callable
+    template<typename Fallback, typename R, typename... Params>
+    class FallbackStorage<Fallback, R(Params..., ...)> {
+    public:
+        static constexpr bool enabled = false;
+
+        template<typename... Args>
+        [[noreturn]] R operator()(Args&&...) {
+            MissingFallback();
+        }
+    };
+
+    template<typename R, typename... Params>
+    class FallbackStorage<DynamicLink::FunctionFallback, R(Params...)> {
+    public:
+        static constexpr bool enabled = true;
+
+        template<typename T>
+        void set(T&& callable) {
+            this->function = std::forward<T>(callable);
+        }
+
+        R operator()(Params... params) {
+            if (!this->function) {
+                MissingFallback();
+            }
+            return this->function(std::forward<Params>(params)...);
+        }
+
+    private:
+        std::function<R(Params...)> function;
+    };
+
+    template<std::size_t Capacity, typename R, typename... Params>
+    class FallbackStorage<DynamicLink::InlineFallback<Capacity>, R(Params...)> {
+    public:
+        static constexpr bool enabled = true;
+
+        FallbackStorage() = default;
+        FallbackStorage(FallbackStorage&& other) noexcept {
+            this->take(other);
+        }
+        FallbackStorage& operator=(FallbackStorage&& other) noexcept {
+            if (this != &other) {
+                this->reset();
+                this->take(other);
+            }
+            return *this;
+        }
+        ~FallbackStorage() {
+            this->reset();
+        }
+
+        template<typename T>
+        void set(T&& callable) {
+            using Callable = std::decay_t<T>;
+            static_assert(sizeof(Callable) <= Capacity && alignof(Callable) <= alignof(std::max_align_t),
+                "fallback does not fit, raise the InlineFallback capacity");
+            static_assert(std::is_nothrow_move_constructible_v<Callable>,
+                "inline fallbacks have to be nothrow movable");
+            this->reset();
+            ::new (static_cast<void*>(this->buffer)) Callable(std::forward<T>(callable));
+            this->invoke = [](void* self, Params... params) -> R {
+                return std::invoke(*static_cast<Callable*>(self), std::forward<Params>(params)...);
+            };
+            this->relocate = [](void* self, void* target) noexcept {
+                if (target != nullptr) {
+                    ::new (target) Callable(std::move(*static_cast<Callable*>(self)));
+                }
+                static_cast<Callable*>(self)->~Callable();
+            };
+        }
+
+        R operator()(Params... params) {
+            if (this->invoke == nullptr) {
+                MissingFallback();
+            }
+            return this->invoke(this->buffer, std::forward<Params>(params)...);
+        }
+
+    private:
+        // moves into `target`, or only destroys when it is null
+        using Relocate = void (*)(void* self, void* target) noexcept;
+
+        void reset() noexcept {
+            if (this->relocate != nullptr) {
+                this->relocate(this->buffer, nullptr);
+                this->invoke = nullptr;
+                this->relocate = nullptr;
+            }
+        }
+        void take(FallbackStorage& other) noexcept {
+            if (other.relocate != nullptr) {
+                other.relocate(other.buffer, this->buffer);
+                this->invoke = std::exchange(other.invoke, nullptr);
+                this->relocate = std::exchange(other.relocate, nullptr);
+            }
+        }
+
+        alignas(std::max_align_t) unsigned char buffer[Capacity]{};
+        R (*invoke)(void*, Params...){nullptr};
+        Relocate relocate{nullptr};
+    };
+}
+
+#endif //DYNAMICLINK_WRAPPERPOLICIES_H
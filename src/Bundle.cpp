@@ -0,0 +1,229 @@
+//
+// Created by DS on 2025/12/20.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <unordered_map>
+#include "internal/Bundle.h"
+#include "internal/ElfFile.h"
+#include "internal/Fork.h"
+#include "internal/LibraryFile.h"
+#include "internal/Trace.h"
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr std::size_t blockSize = 512;
+
+    // tar numbers are octal text, NUL or space terminated
+    std::optional<std::size_t> ParseOctal(const std::span<const std::byte> field) {
+        std::size_t value = 0;
+        bool digits = false;
+        for (const std::byte byte : field) {
+            const auto character = static_cast<char>(byte);
+            if (character >= '0' && character <= '7') {
+                value = value * 8 + static_cast<std::size_t>(character - '0');
+                digits = true;
+            } else if (character == '\0' || character == ' ') {
+                if (digits) {
+                    break;
+                }
+            } else {
+                return std::nullopt;
+            }
+        }
+        return value;
+    }
+
+    std::string_view Field(const std::span<const std::byte> header, const std::size_t offset, const std::size_t size) {
+        const auto* text = reinterpret_cast<const char*>(header.data() + offset);
+        return {text, strnlen(text, size)};
+    }
+
+    std::string_view FileName(const std::string_view name) {
+        const auto separator = name.find_last_of('/');
+        return separator == std::string_view::npos ? name : name.substr(separator + 1);
+    }
+}
+
+std::optional<std::vector<Detail::BundleMember>> Detail::ReadBundle(const std::span<const std::byte> archive) {
+    std::vector<BundleMember> members;
+    std::string_view longName{};
+    for (std::size_t offset = 0; offset + blockSize <= archive.size();) {
+        const auto header = archive.subspan(offset, blockSize);
+        if (std::ranges::all_of(header, [](const std::byte byte) { return byte == std::byte{0}; })) {
+            return members; // end-of-archive block
+        }
+        const auto size = ParseOctal(header.subspan(124, 12));
+        const std::size_t data = offset + blockSize;
+        if (!size || data + *size > archive.size()) {
+            return std::nullopt;
+        }
+        const auto content = archive.subspan(data, *size);
+        const auto type = static_cast<char>(header[156]);
+        if (type == 'L') {
+            // GNU long name, applies to the next header
+            const auto* text = reinterpret_cast<const char*>(content.data());
+            longName = {text, strnlen(text, content.size())};
+        } else {
+            if (type == '0' || type == '\0') {
+                const std::string_view name = !longName.empty() ? longName : Field(header, 0, 100);
+                if (const auto file = FileName(name); !file.empty()) {
+                    members.push_back({file, content});
+                }
+            }
+            longName = {};
+        }
+        offset = data + (*size + blockSize - 1) / blockSize * blockSize;
+    }
+    return members;
+}
+
+#ifdef __linux__
+
+bool Detail::RegisterMemoryLibrary(const std::string& name, const std::span<const std::byte> image) {
+    const int file = memfd_create(FileName(name).data(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (file < 0) {
+        return false;
+    }
+    for (std::size_t written = 0; written < image.size();) {
+        const ssize_t count = write(file, image.data() + written, image.size() - written);
+        if (count <= 0) {
+            close(file);
+            return false;
+        }
+        written += static_cast<std::size_t>(count);
+    }
+    // the image can't change under the loader anymore
+    fcntl(file, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    AddMemoryLibrary(IsFullName(name) ? name : GetFullName(name), file);
+    return true;
+}
+
+std::optional<std::vector<std::string>> Detail::RegisterBundle(const std::string& file, const std::string& prefix) {
+    [[maybe_unused]] const TraceSpan span("bundle unpack", file);
+    const int descriptor = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+        return std::nullopt;
+    }
+    struct stat status{};
+    if (fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+        close(descriptor);
+        return std::nullopt;
+    }
+    const auto size = static_cast<std::size_t>(status.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        return std::nullopt;
+    }
+    std::optional<std::vector<std::string>> names;
+    if (const auto members = ReadBundle({static_cast<const std::byte*>(mapping), size})) {
+        names.emplace();
+        for (const auto& [member, image] : *members) {
+            auto name = prefix.empty() ? std::string(member) : std::format("{}/{}", prefix, member);
+            if (!RegisterMemoryLibrary(name, image)) {
+                names.reset();
+                break;
+            }
+            names->push_back(std::move(name));
+        }
+    }
+    munmap(mapping, size);
+    return names;
+}
+
+std::optional<std::vector<std::string>> Detail::BundleLoadOrder(const std::vector<std::string>& names) {
+    std::unordered_map<std::string, std::size_t> sonames, files;
+    std::vector<std::vector<std::string>> needed(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        const auto file = GetLibraryPath(IsFullName(names[i]) ? names[i] : GetFullName(names[i]));
+        if (!file) {
+            std::cerr << std::format("bundle member {} is not registered\n", names[i]);
+            return std::nullopt;
+        }
+        needed[i] = ReadNeededLibraries(*file);
+        if (auto soname = ReadSoname(*file); !soname.empty()) {
+            sonames.emplace(std::move(soname), i);
+        }
+        files.emplace(FileName(names[i]), i);
+    }
+    std::vector<std::size_t> waiting(names.size(), 0);
+    std::vector<std::vector<std::size_t>> dependents(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        for (const auto& soname : needed[i]) {
+            const auto member = sonames.find(soname);
+            if (member == sonames.end()) {
+                if (files.contains(soname)) {
+                    std::cerr << std::format("bundle member {} needs {}, which the bundle holds without that soname"
+                        ", the loader would search the disk for it\n", names[i], soname);
+                    return std::nullopt;
+                }
+                continue; // outside the bundle, found by the loader as usual
+            }
+            void* loaded;
+            {
+                std::shared_lock loader(loaderMutex);
+                loaded = dlopen(soname.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+                if (loaded != nullptr) {
+                    dlclose(loaded);
+                }
+            }
+            if (loaded != nullptr) {
+                std::cerr << std::format("bundle member {} needs {}, which a library loaded before the bundle"
+                    " already provides, the loader would bind to that one\n", names[i], soname);
+                return std::nullopt;
+            }
+            if (member->second != i) {
+                ++waiting[i];
+                dependents[member->second].push_back(i);
+            }
+        }
+    }
+    // archive order among members that are ready at the same time
+    std::vector<std::string> order;
+    std::vector<std::size_t> ready;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (waiting[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+    for (std::size_t next = 0; next < ready.size(); ++next) {
+        order.push_back(names[ready[next]]);
+        for (const auto dependent : dependents[ready[next]]) {
+            if (--waiting[dependent] == 0) {
+                ready.push_back(dependent);
+            }
+        }
+    }
+    if (order.size() != names.size()) {
+        std::cerr << "bundle members need each other in a cycle\n";
+        return std::nullopt;
+    }
+    return order;
+}
+
+#else
+
+bool Detail::RegisterMemoryLibrary(const std::string&, std::span<const std::byte>) {
+    return false;
+}
+
+std::optional<std::vector<std::string>> Detail::RegisterBundle(const std::string&, const std::string&) {
+    return std::nullopt;
+}
+
+std::optional<std::vector<std::string>> Detail::BundleLoadOrder(const std::vector<std::string>& names) {
+    return names;
+}
+
+#endif
@@ -1,113 +1,677 @@
 //
-
 // Created by DS on 2025/11/10.
 //
 
-#include <future>
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <ranges>
 #include <chrono>
 #include "internal/CacheManager.h"
+#include "internal/Fork.h"
+#include "internal/ReloadState.h"
+
+namespace {
+    void CloseLibrary(const LHANDLE handle) {
+        std::shared_lock loader(Detail::loaderMutex);
+        UNLOAD_LIB(handle);
+    }
+}
 
 LHANDLE
-Detail::CacheManager::getLibraryHandle(const std::string &lib) {
-    std::shared_lock lock(this->mutex);
-    if (const auto cache = this->libraries.find(lib); cache != this->libraries.end()) {
+Detail::CacheManager::getLibraryHandle(const LibraryId lib) const {
+    const Shard& shard = this->shardOf(lib);
+    std::shared_lock lock(shard.mutex);
+    if (const auto cache = shard.libraries.find(lib); cache != shard.libraries.end()) {
         return cache->second.handle;
     }
     return nullptr;
 }
 
 void
-Detail::CacheManager::operator()(const std::string& lib, const LHANDLE handle){
-    std::unique_lock lock(this->mutex);
-    if (!this->libraries.contains(lib)) {
-        this->libraries[lib].handle = handle;
+Detail::CacheManager::operator()(const LibraryId lib, const LHANDLE handle){
+    Shard& shard = this->shardOf(lib);
+    std::unique_lock lock(shard.mutex);
+    if (const auto [cache, inserted] = shard.libraries.try_emplace(lib); inserted) {
+        cache->second.handle = handle;
+        cache->second.resolver = SymbolResolver(handle);
+        if (PerfMapEnabled()) {
+            WritePerfMap(cache->second.resolver.exports(), NameOf(lib));
+        }
+        // stable pointers handed out before an unload follow the library back
+        std::lock_guard parkedLock(this->trampolineMutex);
+        if (auto parked = this->parkedTrampolines.extract(lib); !parked.empty()) {
+            if (std::ranges::any_of(parked.mapped(), &StableEntry::pinning)) {
+                PinLibrary(handle);
+            }
+            for (const auto& entry : parked.mapped()) {
+                retargetSlot(entry, cache->second.resolver(NameOf(entry.function).c_str()));
+            }
+            cache->second.trampolines = std::move(parked.mapped());
+        }
+        // wrappers that fell back while the library was unloaded look their function up again
+        libraryGeneration.fetch_add(1, std::memory_order_acq_rel);
+    } else {
+        CloseLibrary(handle); // loaded concurrently, keep a single reference
     }
 }
 
 void
-Detail::CacheManager::operator()(const std::string& lib, const std::string& func, const uintptr_t function) {
-    std::unique_lock lock(this->mutex);
-    this->libraries[lib].functions[func] = function;
+Detail::CacheManager::operator()(const LibraryId lib, const SymbolId func, const uintptr_t function) {
+    Shard& shard = this->shardOf(lib);
+    std::unique_lock lock(shard.mutex);
+    const auto cache = shard.libraries.find(lib);
+    if (cache == shard.libraries.end()) {
+        return;
+    }
+    if (const auto [descriptor, inserted] = cache->second.functions.try_emplace(func); inserted) {
+        descriptor->second = DescriptorTable::instance().allocate(function);
+    } else {
+        DescriptorTable::instance().at(descriptor->second.index)
+            .functionPointer.store(function, std::memory_order_release);
+    }
+    cache->second.missing.erase(func);
+}
+
+std::vector<Detail::CacheManager::CachedFunction>
+Detail::CacheManager::cachedFunctions() const {
+    std::vector<CachedFunction> functions;
+    for (const auto& shard : this->shards) {
+        std::shared_lock lock(shard.mutex);
+        for (const auto& [lib, cache] : shard.libraries) {
+            for (const auto& [function, descriptor] : cache.functions) {
+                functions.push_back({lib, function, descriptor.index});
+            }
+        }
+    }
+    return functions;
+}
+
+std::vector<std::string>
+Detail::CacheManager::listFunctions(const LibraryId lib, const std::string_view prefix) const {
+    const Shard& shard = this->shardOf(lib);
+    std::shared_lock lock(shard.mutex);
+    if (const auto cache = shard.libraries.find(lib); cache != shard.libraries.end()) {
+        return cache->second.resolver.functions(prefix);
+    }
+    return {};
 }
 
 bool
-Detail::CacheManager::containsLibrary(const std::string& lib) const {
-    std::shared_lock lock(this->mutex);
-    return this->libraries.contains(lib);
+Detail::CacheManager::containsLibrary(const LibraryId lib) const {
+    const Shard& shard = this->shardOf(lib);
+    std::shared_lock lock(shard.mutex);
+    return shard.libraries.contains(lib);
 }
 
 bool
-Detail::CacheManager::containsFunction(const std::string &lib, const std::string &func){
-    std::shared_lock lock(this->mutex);
-    if (this->libraries.contains(lib)) {
-        return this->libraries[lib].functions.contains(func);
+Detail::CacheManager::containsFunction(const LibraryId lib, const SymbolId func) const {
+    const Shard& shard = this->shardOf(lib);
+    std::shared_lock lock(shard.mutex);
+    if (const auto cache = shard.libraries.find(lib); cache != shard.libraries.end()) {
+        return cache->second.functions.contains(func);
     }
     return false;
 }
 
-Detail::FunctionDescriptor*
-Detail::CacheManager::getFunctionDescriptor(const std::string& lib, const std::string& func) {
-    std::shared_lock lock(this->mutex);
-    return &this->libraries[lib].functions[func];
+Detail::DescriptorHandle
+Detail::CacheManager::getFunctionDescriptor(const LibraryId lib, const SymbolId func) const {
+    const Shard& shard = this->shardOf(lib);
+    std::shared_lock lock(shard.mutex);
+    const auto cache = shard.libraries.find(lib);
+    if (cache == shard.libraries.end()) {
+        return {};
+    }
+    const auto descriptor = cache->second.functions.find(func);
+    return descriptor == cache->second.functions.end() ? DescriptorHandle{} : descriptor->second;
+}
+
+Detail::DescriptorHandle
+Detail::CacheManager::findFunction(const LibraryId lib, const SymbolId func) {
+    Shard& shard = this->shardOf(lib);
+    {
+        std::shared_lock lock(shard.mutex);
+        const auto cache = shard.libraries.find(lib);
+        if (cache == shard.libraries.end()) {
+            return {};
+        }
+        if (const auto descriptor = cache->second.functions.find(func);
+            descriptor != cache->second.functions.end()) {
+            return descriptor->second;
+        }
+        if (cache->second.missing.contains(func)) {
+            return {};
+        }
+    }
+    std::unique_lock lock(shard.mutex, std::defer_lock);
+    LockTimed(lock);
+    const auto cache = shard.libraries.find(lib);
+    if (cache == shard.libraries.end()) {
+        return {};
+    }
+    if (const auto descriptor = cache->second.functions.find(func);
+        descriptor != cache->second.functions.end()) {
+        return descriptor->second;
+    }
+    if (cache->second.missing.contains(func)) {
+        return {};
+    }
+    [[maybe_unused]] const OperationTimer timer(Operation::Resolve);
+    [[maybe_unused]] const TraceSpan span("symbol resolution", NameOf(func));
+    const auto function = cache->second.resolver(NameOf(func).c_str());
+    if (function == 0U) {
+        cache->second.missing.insert(func);
+        return {};
+    }
+    return cache->second.functions[func] = DescriptorTable::instance().allocate(function);
 }
 
 Detail::CacheManager::~CacheManager() {
-    for (const auto &[handle, functions] :
-        this->libraries | std::views::values) {
-        UNLOAD_LIB(handle);
+    if (this->reclaimer.joinable()) {
+        this->reclaimer.request_stop();
+        this->reclaimer.join(); // closes whatever is still retired
+    }
+    for (auto& shard : this->shards) {
+        for (const auto& cache :
+            shard.libraries | std::views::values) {
+            CloseLibrary(cache.handle);
+        }
+        shard.libraries.clear();
+    }
+    for (const auto& interface : this->interfaceTables) {
+        if (const void* table = interface->current.exchange(nullptr)) {
+            interface->destroy(table);
+        }
     }
-    this->libraries.clear();
 }
 
-void Detail::CacheManager::unloadLibrary(const std::string &lib){
+void Detail::CacheManager::unloadLibrary(const LibraryId lib){
     this->doUnloadLibrary(lib);
 }
 
 
-void
-Detail::CacheManager::reloadLibrary(const std::string &oldLib, const std::string &newLib) {
-    std::unique_lock lock(this->mutex);
-    if (!libraries.contains(oldLib)) {
-        std::cerr << "Library not found: " << oldLib;
-        std::terminate();
+std::optional<Detail::CacheManager::PreparedReload>
+Detail::CacheManager::prepareReload(const LibraryId oldLib, const LibraryId newLib) {
+    std::vector<SymbolId> functions;
+    std::vector<InterfaceTable*> interfaces;
+    SymbolResolver previous;
+    LHANDLE pinned;
+    {
+        const Shard& from = this->shardOf(oldLib);
+        std::shared_lock lock(from.mutex);
+        const auto old = from.libraries.find(oldLib);
+        // unloaded or reloaded by another thread since the caller looked
+        if (old == from.libraries.end()) {
+            return std::nullopt;
+        }
+        // the resolver points into the old image, which has to stay mapped until publish
+        pinned = RetainLibrary(old->second.handle);
+        if (pinned == nullptr) {
+            return std::nullopt;
+        }
+        for (const auto function : old->second.functions | std::views::keys) {
+            functions.push_back(function);
+        }
+        for (const auto& entry : old->second.trampolines) {
+            functions.push_back(entry.function);
+        }
+        interfaces = old->second.interfaces;
+        previous = old->second.resolver;
+    }
+
+    // loading and symbol lookup run without any shard held
+    [[maybe_unused]] const TraceSpan span("reload prepare", NameOf(newLib));
+    InheritLoadOptions(oldLib, newLib);
+    const LHANDLE handle = LoadLibraryWithCheck(NameOf(newLib));
+    PreparedReload prepared{handle, SymbolResolver(handle)};
+    prepared.previous = pinned;
+    if (PerfMapEnabled()) {
+        WritePerfMap(prepared.resolver.exports(), NameOf(newLib));
+    }
+    const auto resolve = [&](const SymbolId function) {
+        const auto [address, inserted] = prepared.addresses.try_emplace(function);
+        if (inserted) {
+            address->second = prepared.resolver(NameOf(function).c_str());
+        }
+        return address->second;
+    };
+    for (const auto function : functions) {
+        resolve(function);
+    }
+    std::vector<uintptr_t> addresses;
+    for (auto* interface : interfaces) {
+        addresses.clear();
+        for (const auto symbol : interface->symbols) {
+            addresses.push_back(resolve(symbol));
+        }
+        if (std::ranges::find(addresses, 0U) == addresses.end()) {
+            prepared.interfaces.emplace(interface, interface->build(addresses.data()));
+        }
+    }
+    // the new version warms up, then takes over the old one's state while the old one still serves
+    if (!HandOverState(previous, prepared.resolver, NameOf(newLib), prepared.handedState)) {
+        abandonReload(prepared);
+        return std::nullopt;
+    }
+    return prepared;
+}
+
+void Detail::CacheManager::abandonReload(PreparedReload& prepared) {
+    for (const auto& [interface, unused] : prepared.interfaces) {
+        interface->destroy(unused);
+    }
+    CloseLibrary(prepared.handle);
+    // a state the new version copied still belongs to the old one
+    if (const auto& state = prepared.handedState; state.release != nullptr) {
+        state.release(state.data, state.size);
+    }
+    CloseLibrary(prepared.previous);
+}
+
+bool
+Detail::CacheManager::reloadLibrary(const LibraryId oldLib, const LibraryId newLib) {
+    [[maybe_unused]] const OperationTimer timer(Operation::Reload);
+    [[maybe_unused]] const TraceSpan span("reload", NameOf(oldLib));
+    auto preparedReload = this->prepareReload(oldLib, newLib);
+    if (!preparedReload) {
+        return false;
+    }
+    PreparedReload& prepared = *preparedReload;
+
+    // publish: only pointer stores and map updates happen under the shard locks
+    Shard& from = this->shardOf(oldLib);
+    Shard& to = this->shardOf(newLib);
+    std::unique_lock fromLock(from.mutex, std::defer_lock);
+    std::unique_lock toLock(to.mutex, std::defer_lock);
+    {
+        [[maybe_unused]] const OperationTimer wait(Operation::LockWait);
+        if (&from == &to) {
+            fromLock.lock();
+        } else {
+            std::lock(fromLock, toLock);
+        }
+    }
+    std::optional<OperationTimer> publish(std::in_place, Operation::ReloadPublish);
+    std::optional<TraceSpan> publishSpan(std::in_place, "reload publish", NameOf(newLib));
+
+    auto old = from.libraries.extract(oldLib);
+    if (old.empty()) {
+        // unloaded while the new version was prepared, nothing to switch from anymore
+        fromLock.unlock();
+        if (toLock.owns_lock()) {
+            toLock.unlock();
+        }
+        abandonReload(prepared);
+        return false;
+    }
+    auto& cache = to.libraries[newLib];
+    if (cache.handle == nullptr) {
+        cache.handle = prepared.handle;
+        cache.resolver = prepared.resolver;
+    } else {
+        CloseLibrary(prepared.handle); // already cached, drop the extra reference
+    }
+    // descriptors move to the new library in place, handles held by wrappers stay valid
+    auto& table = DescriptorTable::instance();
+    for (const auto& [function, descriptor] : old.mapped().functions) {
+        const auto resolved = prepared.addresses.find(function);
+        // cached while the new library was loading
+        const auto address = resolved != prepared.addresses.end()
+            ? resolved->second : cache.resolver(NameOf(function).c_str());
+        if (address == 0U || cache.functions.contains(function)) {
+            table.release(descriptor);
+            continue;
+        }
+        table.at(descriptor.index).functionPointer.store(address, std::memory_order_release);
+        cache.functions.emplace(function, descriptor);
+    }
+    // trampolines and static slots keep their entry, only the slot is rewritten
+    if (std::ranges::any_of(old.mapped().trampolines, &StableEntry::pinning)
+        && std::ranges::none_of(cache.trampolines, &StableEntry::pinning)) {
+        PinLibrary(cache.handle);
+    }
+    for (const auto& entry : old.mapped().trampolines) {
+        const auto resolved = prepared.addresses.find(entry.function);
+        retargetSlot(entry, resolved != prepared.addresses.end()
+            ? resolved->second : cache.resolver(NameOf(entry.function).c_str()));
+        cache.trampolines.push_back(entry);
+    }
+    // bound interfaces switch as a whole, the old tables are freed once no call uses them
+    RetiredLibrary retired{old.mapped().handle};
+    retired.state = prepared.handedState;
+    for (auto* interface : old.mapped().interfaces) {
+        const void* fresh;
+        if (const auto built = prepared.interfaces.find(interface); built != prepared.interfaces.end()) {
+            fresh = built->second;
+            prepared.interfaces.erase(built);
+        } else {
+            fresh = resolveInterface(cache, *interface);
+        }
+        interface->library.store(newLib, std::memory_order_relaxed);
+        if (const void* previous = interface->current.exchange(fresh, std::memory_order_acq_rel)) {
+            retired.interfaces.push_back({interface->destroy, previous});
+        }
+        cache.interfaces.push_back(interface);
+    }
+
+    {
+        // keep every older name pointing at the newest version
+        std::unique_lock aliasLock(this->aliasMutex);
+        for (auto& name : this->libraryAlias | std::views::values) {
+            if (name == oldLib) {
+                name = newLib;
+            }
+        }
+        this->libraryAlias.erase(newLib);
+        this->libraryAlias[oldLib] = newLib;
+    }
+
+    retired.generation = libraryGeneration.fetch_add(1, std::memory_order_acq_rel) + 1;
+    fromLock.unlock();
+    if (toLock.owns_lock()) {
+        toLock.unlock();
     }
-    const LHANDLE handle = LoadLibraryWithCheck(newLib);
-    this->libraryAlias[oldLib] = newLib;
-    for (const auto& functionName : this->libraries[oldLib].functions | std::views::keys) {
-        if (const auto function = GET_FUNC(handle, functionName.c_str())) {
-            this->libraries[newLib].functions[functionName] = function;
+    publish.reset();
+    publishSpan.reset();
+    // built for an interface that was unbound from the old library meanwhile, never published
+    for (const auto& [interface, unused] : prepared.interfaces) {
+        interface->destroy(unused);
+    }
+    this->retire(std::move(retired));
+    CloseLibrary(prepared.previous); // published, the retired entry holds the old image now
+    return true;
+}
+
+void Detail::CacheManager::retire(RetiredLibrary retired) {
+    {
+        std::lock_guard lock(this->retireMutex);
+        this->retiredLibraries.push_back(std::move(retired));
+        if (!this->reclaimer.joinable()) {
+            this->reclaimer = std::jthread([this](const std::stop_token& stop) { this->reclaim(stop); });
+        }
+    }
+    this->retireSignal.notify_one();
+}
+
+void Detail::CacheManager::reclaim(const std::stop_token& stop) {
+    std::unique_lock lock(this->retireMutex);
+    while (true) {
+        this->retireSignal.wait(lock, stop, [this] { return !this->retiredLibraries.empty(); });
+        if (this->retiredLibraries.empty()) {
+            return; // stop requested and nothing left to close
+        }
+        auto batch = std::move(this->retiredLibraries);
+        this->retiredLibraries.clear();
+        lock.unlock();
+        closeRetired(batch);
+        lock.lock();
+    }
+}
+
+void Detail::CacheManager::closeRetired(const std::vector<RetiredLibrary>& batch) {
+    std::uint64_t target = 0;
+    for (const auto& retired : batch) {
+        target = std::max(target, retired.generation);
+    }
+    {
+        [[maybe_unused]] const TraceSpan span("reclaim drain", {});
+        SynchronizeEpoch(target);
+    }
+    for (const auto& retired : batch) {
+        for (const auto& [destroy, previous] : retired.interfaces) {
+            destroy(previous);
+        }
+        if (const auto& state = retired.state; state.release != nullptr) {
+            state.release(state.data, state.size);
+        }
+        CloseLibrary(retired.handle);
+    }
+}
+
+void Detail::CacheManager::prepareForFork() {
+    // a child has no reclaimer, nothing retired may be left for it
+    std::vector<RetiredLibrary> batch;
+    {
+        std::lock_guard lock(this->retireMutex);
+        batch = std::move(this->retiredLibraries);
+        this->retiredLibraries.clear();
+    }
+    if (!batch.empty()) {
+        closeRetired(batch);
+    }
+
+    std::vector<InterfaceTable*> interfaces;
+    {
+        std::lock_guard lock(this->interfaceMutex);
+        for (const auto& interface : this->interfaceTables) {
+            interfaces.push_back(interface.get());
+        }
+    }
+    for (auto* interface : interfaces) {
+        if (interface->current.load(std::memory_order_acquire) == nullptr) {
+            this->attachInterface(*interface);
         }
     }
-    this->unloadLibrary(oldLib);
+
+    std::vector<LHANDLE> handles;
+    for (const auto& shard : this->shards) {
+        std::shared_lock lock(shard.mutex);
+        for (const auto& cache : shard.libraries | std::views::values) {
+            handles.push_back(cache.handle);
+        }
+    }
+    for (const auto handle : handles) {
+        PrefaultImage(handle);
+    }
 }
 
-bool Detail::CacheManager::isOutOfDate(const std::string & libName) const {
-    std::shared_lock lock(this->mutex);
-    return this->libraryAlias.contains(libName);
+void Detail::CacheManager::lockForFork() {
+    // the order every other path takes them in
+    for (auto& shard : this->shards) {
+        shard.mutex.lock();
+    }
+    this->trampolineMutex.lock();
+    this->aliasMutex.lock();
+    this->interfaceMutex.lock();
+    this->retireMutex.lock();
 }
 
-std::string Detail::CacheManager::getNewName(const std::string & libName) {
-    std::shared_lock lock(this->mutex);
-    if (this->libraryAlias.contains(libName)) {
-        return this->libraryAlias[libName];
+void Detail::CacheManager::unlockAfterFork(const bool child) {
+    if (child) {
+        // the reclaimer only exists in the parent, the next retire starts one here
+        if (this->reclaimer.joinable()) {
+            this->reclaimer.detach();
+        }
+        std::construct_at(&this->retireSignal); // may still count the parent's reclaimer as a waiter
+    }
+    ReleaseAfterFork(this->retireMutex, child);
+    ReleaseAfterFork(this->interfaceMutex, child);
+    ReleaseAfterFork(this->aliasMutex, child);
+    ReleaseAfterFork(this->trampolineMutex, child);
+    for (auto& shard : this->shards | std::views::reverse) {
+        ReleaseAfterFork(shard.mutex, child);
     }
-    return libName;
 }
 
-void Detail::CacheManager::doUnloadLibrary(const std::string & lib) {
-    std::unique_lock lock(this->mutex);
-    for (auto& descriptor :
-        this->libraries[lib].functions | std::views::values) {
-        descriptor.valid.lock(); // descriptor will be destroyed so avoid the RAII
-        descriptor.functionPointer = 0;
-        descriptor.valid.unlock();
+Detail::LibraryId Detail::CacheManager::getNewName(const LibraryId lib) const {
+    std::shared_lock lock(this->aliasMutex);
+    if (const auto alias = this->libraryAlias.find(lib); alias != this->libraryAlias.end()) {
+        return alias->second;
+    }
+    return lib;
+}
+
+void Detail::CacheManager::doUnloadLibrary(const LibraryId lib) {
+    [[maybe_unused]] const TraceSpan span("unload", NameOf(lib));
+    Shard& shard = this->shardOf(lib);
+    std::unique_lock lock(shard.mutex, std::defer_lock);
+    LockTimed(lock);
+    auto cache = shard.libraries.extract(lib);
+    if (cache.empty()) {
+        return;
+    }
+    for (const auto descriptor :
+        cache.mapped().functions | std::views::values) {
+        DescriptorTable::instance().release(descriptor);
+    }
+    if (auto& trampolines = cache.mapped().trampolines; !trampolines.empty()) {
+        for (const auto& entry : trampolines) {
+            retargetSlot(entry, 0);
+        }
+        std::lock_guard parkedLock(this->trampolineMutex);
+        auto& parked = this->parkedTrampolines[lib];
+        parked.insert(parked.end(), trampolines.begin(), trampolines.end());
     }
-    UNLOAD_LIB(instance().libraries[lib].handle);
-    this->libraries.erase(lib);
-    if (this->libraryAlias.contains(lib)) {
+    std::vector<RetiredInterface> retired;
+    for (auto* interface : cache.mapped().interfaces) {
+        if (const void* previous = interface->current.exchange(nullptr, std::memory_order_acq_rel)) {
+            retired.push_back({interface->destroy, previous});
+        }
+    }
+    {
+        std::unique_lock aliasLock(this->aliasMutex);
         this->libraryAlias.erase(lib);
     }
+
+    // wrappers see the new generation and stop using the cached pointers,
+    // calls already running on them have to return before the handle goes away
+    const auto target = libraryGeneration.fetch_add(1, std::memory_order_acq_rel) + 1;
+    lock.unlock();
+    {
+        [[maybe_unused]] const TraceSpan drain("unload drain", NameOf(lib));
+        SynchronizeEpoch(target);
+    }
+    for (const auto& [destroy, previous] : retired) {
+        destroy(previous);
+    }
+    [[maybe_unused]] const TraceSpan close("dlclose", NameOf(lib));
+    CloseLibrary(cache.mapped().handle);
+}
+
+const void*
+Detail::CacheManager::resolveInterface(LibraryCache& cache, const InterfaceTable& interface) {
+    std::vector<uintptr_t> addresses;
+    addresses.reserve(interface.symbols.size());
+    for (const auto symbol : interface.symbols) {
+        if (const auto descriptor = cache.functions.find(symbol); descriptor != cache.functions.end()) {
+            addresses.push_back(LoadDescriptor(descriptor->second));
+            continue;
+        }
+        const auto address = cache.resolver(NameOf(symbol).c_str());
+        if (address == 0U) {
+            return nullptr;
+        }
+        cache.functions.emplace(symbol, DescriptorTable::instance().allocate(address));
+        addresses.push_back(address);
+    }
+    return interface.build(addresses.data());
+}
+
+Detail::InterfaceTable*
+Detail::CacheManager::registerInterface(std::unique_ptr<InterfaceTable> interface) {
+    std::lock_guard lock(this->interfaceMutex);
+    // few distinct interfaces exist, BindInterface may be called for each request
+    for (const auto& known : this->interfaceTables) {
+        if (known->name == interface->name && known->build == interface->build
+            && known->destroy == interface->destroy && known->symbols == interface->symbols) {
+            return known.get();
+        }
+    }
+    return this->interfaceTables.emplace_back(std::move(interface)).get();
+}
+
+bool Detail::CacheManager::attachInterface(InterfaceTable& interface) {
+    const LibraryId lib = this->getNewName(interface.library.load(std::memory_order_relaxed));
+    Shard& shard = this->shardOf(lib);
+    std::unique_lock lock(shard.mutex, std::defer_lock);
+    LockTimed(lock);
+    const auto cache = shard.libraries.find(lib);
+    if (cache == shard.libraries.end()) {
+        return false;
+    }
+    if (interface.current.load(std::memory_order_acquire) != nullptr) {
+        return true; // attached by another thread meanwhile
+    }
+    const void* fresh = resolveInterface(cache->second, interface);
+    if (fresh == nullptr) {
+        return false;
+    }
+    interface.library.store(lib, std::memory_order_relaxed);
+    interface.current.store(fresh, std::memory_order_release);
+    if (std::ranges::find(cache->second.interfaces, &interface) == cache->second.interfaces.end()) {
+        cache->second.interfaces.push_back(&interface);
+    }
+    return true;
+}
+
+void* Detail::CacheManager::stablePointer(const LibraryId lib, const SymbolId func, const uintptr_t fallback) {
+    Shard& shard = this->shardOf(lib);
+    std::unique_lock lock(shard.mutex, std::defer_lock);
+    LockTimed(lock);
+    const auto cache = shard.libraries.find(lib);
+    if (cache == shard.libraries.end()) {
+        return nullptr;
+    }
+    auto& trampolines = cache->second.trampolines;
+    if (const auto entry = std::ranges::find_if(trampolines, [func](const StableEntry& stable) {
+            return stable.function == func && stable.trampoline != StableEntry::noTrampoline;
+        }); entry != trampolines.end()) {
+        return TrampolineTable::instance().entry(entry->trampoline);
+    }
+    const auto descriptor = cache->second.functions.find(func);
+    const uintptr_t address = descriptor != cache->second.functions.end()
+        ? LoadDescriptor(descriptor->second) : cache->second.resolver(NameOf(func).c_str());
+    if (address == 0U && fallback == 0U) {
+        return nullptr;
+    }
+    // calls through a trampoline are not epoch guarded, the image is never unmapped under them
+    if (std::ranges::none_of(trampolines, &StableEntry::pinning)) {
+        PinLibrary(cache->second.handle);
+    }
+    const auto index = TrampolineTable::instance().allocate(address != 0U ? address : fallback);
+    trampolines.push_back({func, &TrampolineTable::instance().slot(index), fallback, index});
+    if (PerfMapEnabled()) {
+        const auto entry = reinterpret_cast<uintptr_t>(TrampolineTable::instance().entry(index));
+        WritePerfMap({{"trampoline:" + NameOf(func), entry, TrampolineTable::entrySize}}, NameOf(lib));
+    }
+    return TrampolineTable::instance().entry(index);
+}
+
+bool Detail::CacheManager::bindSlot(const LibraryId lib, const SymbolId func, std::atomic<uintptr_t>* slot,
+    const uintptr_t fallback, const bool guarded) {
+    Shard& shard = this->shardOf(lib);
+    std::unique_lock lock(shard.mutex, std::defer_lock);
+    LockTimed(lock);
+    const auto cache = shard.libraries.find(lib);
+    if (cache == shard.libraries.end()) {
+        return false;
+    }
+    auto& entries = cache->second.trampolines;
+    if (std::ranges::find(entries, slot, &StableEntry::slot) != entries.end()) {
+        // bound before, still at the fallback when the function has gone missing
+        return slot->load(std::memory_order_acquire) != fallback;
+    }
+    const auto descriptor = cache->second.functions.find(func);
+    const uintptr_t address = descriptor != cache->second.functions.end()
+        ? LoadDescriptor(descriptor->second) : cache->second.resolver(NameOf(func).c_str());
+    if (address == 0U) {
+        return false;
+    }
+    if (!guarded && std::ranges::none_of(entries, &StableEntry::pinning)) {
+        PinLibrary(cache->second.handle);
+    }
+    slot->store(address, std::memory_order_release);
+    entries.push_back({func, slot, fallback, StableEntry::noTrampoline, !guarded});
+    return true;
+}
+
+void Detail::CacheManager::retargetSlot(const StableEntry& entry, const uintptr_t address) {
+    uintptr_t target = address;
+    if (target == 0U) {
+        target = entry.fallback != 0U ? entry.fallback : reinterpret_cast<uintptr_t>(&MissingStableTarget);
+    }
+    // an aligned word store, a caller jumps either to the old or to the new target
+    entry.slot->store(target, std::memory_order_release);
 }
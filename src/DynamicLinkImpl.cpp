@@ -1,91 +1,329 @@
 #include <iostream>
 #include "internal/DynamicLinkImpl.h"
+#include "internal/Bundle.h"
 #include "internal/CacheManager.h"
+#include "internal/Fork.h"
 #include "internal/Platforms.h"
-
-#define instance Detail::CacheManager::instance()
+#include "internal/InterfaceTable.h"
+#include "internal/SymbolCache.h"
 
 #ifdef __linux__
-
-int ldFlag = RTLD_LAZY;
-int GetFlag(){return ldFlag;}
-void SetFlag(int flag){ldFlag = flag;}
-
+#include <link.h>
 #endif
 
-Detail::FunctionDescriptor*
-Detail::GetFunctionImpl(const std::string &lib, const std::string &func) {
-    if (instance.containsLibrary(lib)) {
-        if (instance.containsFunction(lib, func)) {
-            if (auto *const descriptor = instance.getFunctionDescriptor(lib, func); descriptor->functionPointer == 0) {
-                std::cerr << "bad function " << func << "in lib " << lib;
-                std::terminate();
-            }
-            return instance.getFunctionDescriptor(lib, func);
-        }
+#define instance Detail::CacheManager::instance()
 
-        const LHANDLE handle = instance.getLibraryHandle(lib);
-        const auto function = GET_FUNC(handle, func.c_str());
-        if (function == 0U) {
-            std::cerr << std::format("bad function {} in lib {}", func, lib);
+Detail::DescriptorHandle
+Detail::GetFunctionImpl(const LibraryId lib, const SymbolId func) {
+    if (const auto descriptor = instance.getFunctionDescriptor(lib, func); descriptor.valid()) {
+        if (LoadDescriptor(descriptor) == 0) {
+            std::cerr << "bad function " << NameOf(func) << "in lib " << NameOf(lib);
             std::terminate();
         }
-        instance(lib, func, function);
-        return instance.getFunctionDescriptor(lib, func);
+        return descriptor;
     }
 
-    const LHANDLE handle = LoadLibraryWithCheck(lib);
-    const auto function = GET_FUNC(handle, func.c_str());
-    instance(lib, handle);
-    instance(lib, func, function);
-    return instance.getFunctionDescriptor(lib, func);
+    [[maybe_unused]] const TraceSpan span("get function", NameOf(func));
+    if (!instance.containsLibrary(lib)) {
+        instance(lib, LoadLibraryWithCheck(NameOf(lib)));
+    }
+    const auto descriptor = instance.findFunction(lib, func);
+    if (!descriptor.valid()) {
+        std::cerr << std::format("bad function {} in lib {}", NameOf(func), NameOf(lib));
+        std::terminate();
+    }
+    return descriptor;
 }
 
 LHANDLE Detail::LoadLibraryWithCheck(const std::string &lib) {
-    std::string libraryName = lib;
+    return OpenLibrary(lib, true);
+}
+
+LHANDLE Detail::LoadLibraryWithCheck(const std::string &lib, const DynamicLink::LoadOptions &options) {
+    return OpenLibrary(lib, true, options);
+}
+
+LHANDLE Detail::TryLoadLibrary(const std::string &lib) {
+    return OpenLibrary(lib, false);
+}
+
+#ifdef __linux__
+namespace {
+    // the same object by its loaded name, in the namespace it lives in
+    LHANDLE ReopenLibrary(const LHANDLE handle, const int flags) {
+        Lmid_t namespaceId;
+        link_map* map = nullptr;
+        if (dlinfo(handle, RTLD_DI_LMID, &namespaceId) != 0 || dlinfo(handle, RTLD_DI_LINKMAP, &map) != 0
+            || map == nullptr || map->l_name == nullptr || map->l_name[0] == '\0') {
+            return nullptr;
+        }
+        return dlmopen(namespaceId, map->l_name, flags | RTLD_NOLOAD);
+    }
+}
+#endif
+
+LHANDLE Detail::RetainLibrary(const LHANDLE handle) {
+    std::shared_lock loader(loaderMutex);
+#ifdef __linux__
+    return ReopenLibrary(handle, RTLD_LAZY);
+#else
+    char file[MAX_PATH];
+    return GetModuleFileNameA(handle, file, MAX_PATH) != 0 ? LoadLibraryA(file) : nullptr;
+#endif
+}
+
+void Detail::PinLibrary(const LHANDLE handle) {
+    std::shared_lock loader(loaderMutex);
+#ifdef __linux__
+    // RTLD_NODELETE sticks to the image, the reference taken to set it is dropped again
+    if (const LHANDLE pinned = ReopenLibrary(handle, RTLD_LAZY | RTLD_NODELETE)) {
+        UNLOAD_LIB(pinned);
+    }
+#else
+    HMODULE pinned;
+    GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+        reinterpret_cast<LPCSTR>(handle), &pinned);
+#endif
+}
+
+LHANDLE Detail::OpenLibrary(const std::string &lib, const bool required) {
+    return OpenLibrary(lib, required, GetLoadOptions(InternName(lib)));
+}
+
+LHANDLE Detail::OpenLibrary(const std::string &lib, const bool required, const DynamicLink::LoadOptions &options) {
+    [[maybe_unused]] const OperationTimer timer(Operation::Load);
+    [[maybe_unused]] const TraceSpan span("load", lib);
+    auto [libraryName, isolated] = SplitInstance(lib);
     if (!IsFullName(libraryName)) {
         libraryName = GetFullName(libraryName);
     }
-    if (!IsValidPath(libraryName)) {
+    std::optional<path> file;
+    {
+        [[maybe_unused]] const TraceSpan resolution("path resolution", lib);
+        file = GetLibraryPath(libraryName);
+    }
+    if (!file) {
+        if (!required) {
+            return nullptr;
+        }
         std::cerr << std::format("lib {} does not exist", lib);
         std::terminate();
     }
-    const LHANDLE handle = LOAD_LIB(libraryName.c_str());
+    const int flags = LoaderFlags(options);
+    LHANDLE handle;
+    {
+        [[maybe_unused]] const TraceSpan open("dlopen", lib);
+        std::shared_lock loader(loaderMutex);
+        handle = isolated
+            ? LOAD_LIB_ISOLATED(file->string().c_str(), flags) : LOAD_LIB(file->string().c_str(), flags);
+    }
     if (handle == nullptr) {
+        if (!required) {
+            return nullptr;
+        }
         std::cerr << std::format("failed at loading{}, here is the system error:\n{}"
             , libraryName, GET_ERROR());
         std::terminate();
     }
+    // not published yet, nothing runs in its text
+    if (options.hugePages) {
+        [[maybe_unused]] const TraceSpan remap("huge page remap", lib);
+        RemapTextToHugePages(handle);
+    }
+    if (options.prewarm) {
+        [[maybe_unused]] const TraceSpan prewarm("prewarm", lib);
+        PrefaultImage(handle);
+    }
     return handle;
 }
 
 
 void DynamicLink::PreloadLibrary(const std::string &lib) {
-    if (!instance.containsLibrary(lib)) {
+    if (const auto id = Detail::InternName(lib); !instance.containsLibrary(id)) {
         const LHANDLE handle = Detail::LoadLibraryWithCheck(lib);
-        instance(lib, handle);
+        instance(id, handle);
     }
 }
 
+void DynamicLink::PreloadLibraryFromMemory(const std::string &lib, const std::span<const std::byte> image) {
+    if (!Detail::RegisterMemoryLibrary(lib, image)) {
+        std::cerr << std::format("failed at registering the memory image of {}", lib);
+        std::terminate();
+    }
+    if (const auto id = Detail::InternName(lib); !instance.containsLibrary(id)) {
+        instance(id, Detail::LoadLibraryWithCheck(lib));
+    }
+}
+
+std::vector<std::string> DynamicLink::PreloadBundle(const std::string &bundle, const std::string &prefix) {
+    auto names = Detail::RegisterBundle(bundle, prefix);
+    if (!names) {
+        std::cerr << std::format("failed at reading bundle {}", bundle);
+        std::terminate();
+    }
+    std::vector<std::string> pending;
+    std::ranges::copy_if(*names, std::back_inserter(pending), [](const std::string &lib) {
+        return !instance.containsLibrary(Detail::InternName(lib));
+    });
+    const auto order = Detail::BundleLoadOrder(pending);
+    if (!order) {
+        std::cerr << std::format("failed at loading bundle {}", bundle);
+        std::terminate();
+    }
+    for (const auto &lib : *order) {
+        instance(Detail::InternName(lib), Detail::LoadLibraryWithCheck(lib));
+    }
+    return std::move(*names);
+}
+
 void DynamicLink::UnloadLibrary(const std::string &lib) {
-    instance.unloadLibrary(lib);
+    instance.unloadLibrary(Detail::InternName(lib));
 }
 
-void DynamicLink::ReloadLibrary(const std::string &oldLib, const std::string &newLib) {
-    instance.reloadLibrary(oldLib, newLib);
+bool DynamicLink::ReloadLibrary(const std::string &oldLib, const std::string &newLib) {
+    return instance.reloadLibrary(Detail::InternName(oldLib), Detail::InternName(newLib));
 }
 
 void DynamicLink::PreloadFunction(const std::string &lib, const std::string &func) {
-    if (!instance.containsFunction(lib, func)) {
-        const LHANDLE handle = instance.getLibraryHandle(lib);
-        instance(lib, func, GET_FUNC(handle, func.c_str()));
+    const auto libId = Detail::InternName(lib);
+    if (const auto funcId = Detail::InternName(func); !instance.containsFunction(libId, funcId)) {
+        PreloadLibrary(lib);
+        instance.findFunction(libId, funcId);
     }
 }
 
-bool Detail::DescriptorShouldUpdate(const std::string &libName) {
-    return instance.isOutOfDate(libName);
+std::vector<std::string> DynamicLink::ListFunctions(const std::string &lib, const std::string_view prefix) {
+    PreloadLibrary(lib);
+    return instance.listFunctions(Detail::InternName(lib), prefix);
+}
+
+std::string DynamicLink::LibraryInstance(const std::string &lib, const std::size_t index) {
+    return std::format("{}{}{}", lib, Detail::instanceSeparator, index);
 }
 
-std::string Detail::GetActualLibraryName(const std::string &oldLib) {
+std::size_t DynamicLink::ThreadShard(const std::size_t count) {
+    static std::atomic<std::size_t> threads{0};
+    thread_local const std::size_t ordinal = threads.fetch_add(1, std::memory_order_relaxed);
+    return ordinal % count;
+}
+
+void DynamicLink::UseHugePages(const bool enable) {
+    auto options = Detail::GetDefaultLoadOptions();
+    options.hugePages = enable;
+    Detail::SetDefaultLoadOptions(options);
+}
+
+void DynamicLink::SetLoadOptions(const std::string &lib, const LoadOptions &options) {
+    Detail::SetLoadOptions(Detail::InternName(lib), options);
+}
+
+void DynamicLink::SetDefaultLoadOptions(const LoadOptions &options) {
+    Detail::SetDefaultLoadOptions(options);
+}
+
+std::size_t DynamicLink::HugePageBytes(const std::string &lib) {
+    const auto handle = instance.getLibraryHandle(instance.getNewName(Detail::InternName(lib)));
+    return handle == nullptr ? 0 : Detail::HugePageTextBytes(handle);
+}
+
+void DynamicLink::EnablePerfMap(const bool enable) {
+    Detail::SetPerfMap(enable);
+}
+
+void DynamicLink::StartTrace() {
+    Detail::StartTrace();
+}
+
+bool DynamicLink::StopTrace(const std::string &file) {
+    return Detail::StopTrace(file);
+}
+
+void DynamicLink::PrepareForFork() {
+    Detail::InstallForkHandlers();
+    // configured but not used yet: loaded now, and bound now so no worker relocates them
+    for (const auto lib : Detail::ConfiguredLibraries()) {
+        if (const auto actual = instance.getNewName(lib); !instance.containsLibrary(actual)) {
+            auto options = Detail::GetLoadOptions(actual);
+            options.binding = Binding::Now;
+            instance(actual, Detail::LoadLibraryWithCheck(Detail::NameOf(actual), options));
+        }
+    }
+    instance.prepareForFork();
+}
+
+void DynamicLink::EnableSymbolCache(const std::string &directory) {
+    Detail::SetSymbolCacheDirectory(directory);
+}
+
+void DynamicLink::UseLoaderCache(const bool enable) {
+    Detail::UseLoaderCache(enable);
+}
+
+Detail::DescriptorHandle Detail::TryGetFunctionImpl(const LibraryId lib, const SymbolId func) {
+    if (const auto descriptor = instance.getFunctionDescriptor(lib, func); descriptor.valid()) {
+        return LoadDescriptor(descriptor) != 0 ? descriptor : DescriptorHandle{};
+    }
+    if (!instance.containsLibrary(lib)) {
+        const LHANDLE handle = TryLoadLibrary(NameOf(lib));
+        if (handle == nullptr) {
+            return {};
+        }
+        instance(lib, handle);
+    }
+    return instance.findFunction(lib, func);
+}
+
+bool DynamicLink::HasFunction(const std::string &lib, const std::string &func) {
+    return Detail::TryGetFunctionImpl(Detail::InternName(lib), Detail::InternName(func)).valid();
+}
+
+Detail::DescriptorHandle Detail::FindFunctionImpl(const LibraryId lib, const SymbolId func) {
+    return instance.findFunction(lib, func);
+}
+
+Detail::InterfaceTable* Detail::BindInterfaceImpl(const LibraryId lib, std::vector<SymbolId> symbols,
+    const InterfaceTable::Build build, const InterfaceTable::Destroy destroy) {
+    if (!instance.containsLibrary(lib)) {
+        instance(lib, LoadLibraryWithCheck(NameOf(lib)));
+    }
+    auto* interface = instance.registerInterface(std::make_unique<InterfaceTable>(
+        lib, lib, std::move(symbols), build, destroy));
+    if (!instance.attachInterface(*interface)) {
+        std::cerr << std::format("bad interface for lib {}, not every symbol could be resolved", NameOf(lib));
+        std::terminate();
+    }
+    return interface;
+}
+
+bool Detail::RebindInterfaceImpl(InterfaceTable* table) {
+    return instance.attachInterface(*table);
+}
+
+Detail::LibraryId Detail::GetActualLibrary(const LibraryId oldLib) {
     return instance.getNewName(oldLib);
-}
\ No newline at end of file
+}
+
+void* Detail::GetStablePointerImpl(const LibraryId lib, const SymbolId func, const uintptr_t fallback) {
+    const LibraryId actual = instance.getNewName(lib);
+    if (!instance.containsLibrary(actual)) {
+        instance(actual, LoadLibraryWithCheck(NameOf(actual)));
+    }
+    void* entry = instance.stablePointer(actual, func, fallback);
+    if (entry == nullptr) {
+        std::cerr << std::format("bad function {} in lib {}", NameOf(func), NameOf(actual));
+        std::terminate();
+    }
+    return entry;
+}
+
+void Detail::BindStaticSlot(const LibraryId lib, const SymbolId func, std::atomic<uintptr_t>* slot,
+    const uintptr_t bootstrap, const bool guarded) {
+    const LibraryId actual = instance.getNewName(lib);
+    if (!instance.containsLibrary(actual)) {
+        instance(actual, LoadLibraryWithCheck(NameOf(actual)));
+    }
+    if (!instance.bindSlot(actual, func, slot, bootstrap, guarded)) {
+        std::cerr << std::format("bad function {} in lib {}", NameOf(func), NameOf(actual));
+        std::terminate();
+    }
+}
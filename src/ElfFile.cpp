@@ -0,0 +1,145 @@
+//
+// Created by DS on 2025/12/11.
+//
+
+#include "internal/ElfFile.h"
+
+#ifdef __linux__
+
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    // read only view of a whole file, unmapped on scope exit
+    class MappedFile {
+    public:
+        explicit MappedFile(const Detail::path& file) {
+            const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            struct stat status{};
+            if (fstat(fd, &status) == 0 && status.st_size > 0) {
+                void* address = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address != MAP_FAILED) {
+                    this->data = static_cast<const unsigned char*>(address);
+                    this->size = status.st_size;
+                }
+            }
+            close(fd);
+        }
+        ~MappedFile() {
+            if (this->data) {
+                munmap(const_cast<unsigned char*>(this->data), this->size);
+            }
+        }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        template<typename T>
+        const T* at(const std::size_t offset, const std::size_t count = 1) const {
+            if (offset > this->size || count > (this->size - offset) / sizeof(T)) {
+                return nullptr;
+            }
+            return reinterpret_cast<const T*>(this->data + offset);
+        }
+
+        const unsigned char* data{nullptr};
+        std::size_t size{0};
+    };
+
+    // file offset of a virtual address, 0 when no PT_LOAD covers it
+    std::size_t OffsetOf(const ElfW(Phdr)* headers, const std::size_t count, const ElfW(Addr) address) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto& header = headers[i];
+            if (header.p_type == PT_LOAD && address >= header.p_vaddr
+                && address < header.p_vaddr + header.p_filesz) {
+                return address - header.p_vaddr + header.p_offset;
+            }
+        }
+        return 0;
+    }
+
+    // strings of every dynamic entry with `tag`, in file order
+    std::vector<std::string> ReadDynamicStrings(const Detail::path& library, const ElfW(Sxword) tag) {
+        std::vector<std::string> values;
+        const MappedFile file(library);
+        const auto* header = file.at<ElfW(Ehdr)>(0);
+        if (header == nullptr || std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0
+            || header->e_ident[EI_CLASS] != (sizeof(void*) == 8 ? ELFCLASS64 : ELFCLASS32)) {
+            return values;
+        }
+        const auto* programs = file.at<ElfW(Phdr)>(header->e_phoff, header->e_phnum);
+        if (programs == nullptr) {
+            return values;
+        }
+        const ElfW(Dyn)* dynamic = nullptr;
+        std::size_t dynamicCount = 0;
+        for (std::size_t i = 0; i < header->e_phnum; ++i) {
+            if (programs[i].p_type == PT_DYNAMIC) {
+                dynamicCount = programs[i].p_filesz / sizeof(ElfW(Dyn));
+                dynamic = file.at<ElfW(Dyn)>(programs[i].p_offset, dynamicCount);
+                break;
+            }
+        }
+        if (dynamic == nullptr) {
+            return values;
+        }
+        std::size_t strings = 0, stringsSize = 0;
+        for (std::size_t i = 0; i < dynamicCount && dynamic[i].d_tag != DT_NULL; ++i) {
+            if (dynamic[i].d_tag == DT_STRTAB) {
+                strings = OffsetOf(programs, header->e_phnum, dynamic[i].d_un.d_ptr);
+            } else if (dynamic[i].d_tag == DT_STRSZ) {
+                stringsSize = dynamic[i].d_un.d_val;
+            }
+        }
+        const auto* table = file.at<char>(strings, stringsSize);
+        if (strings == 0 || table == nullptr) {
+            return values;
+        }
+        for (std::size_t i = 0; i < dynamicCount && dynamic[i].d_tag != DT_NULL; ++i) {
+            if (dynamic[i].d_tag == tag && dynamic[i].d_un.d_val < stringsSize) {
+                const char* name = table + dynamic[i].d_un.d_val;
+                values.emplace_back(name, strnlen(name, stringsSize - dynamic[i].d_un.d_val));
+            }
+        }
+        return values;
+    }
+}
+
+std::vector<std::string> Detail::ReadNeededLibraries(const path& library) {
+    return ReadDynamicStrings(library, DT_NEEDED);
+}
+
+std::string Detail::ReadSoname(const path& library) {
+    auto soname = ReadDynamicStrings(library, DT_SONAME);
+    return soname.empty() ? std::string() : std::move(soname.front());
+}
+
+void Detail::PrefetchLibrary(const path& library) {
+    const int fd = open(library.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+#else
+
+std::vector<std::string> Detail::ReadNeededLibraries(const path&) {
+    return {};
+}
+
+std::string Detail::ReadSoname(const path&) {
+    return {};
+}
+
+void Detail::PrefetchLibrary(const path&) {}
+
+#endif
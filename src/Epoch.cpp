@@ -0,0 +1,108 @@
+//
+// Created by DS on 2025/12/02.
+//
+
+#include <mutex>
+#include <thread>
+#include "internal/Epoch.h"
+#include "internal/Fork.h"
+#include "internal/Platforms.h"
+
+#ifdef __linux__
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::mutex recordMutex;
+    Detail::EpochRecord* records = nullptr; // records are never freed, only recycled
+    std::once_flag barrierInit;
+
+    void InitBarrier() {
+#ifdef _WIN32
+        Detail::asymmetricBarrier = true;
+#elif defined(__linux__)
+        Detail::asymmetricBarrier =
+            syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+#endif
+    }
+
+    // makes every reader's relaxed record store visible, pairs with the signal fence
+    void HeavyBarrier() {
+        if (!Detail::asymmetricBarrier) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return;
+        }
+#ifdef _WIN32
+        FlushProcessWriteBuffers();
+#elif defined(__linux__)
+        syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+#endif
+    }
+
+    struct RecordRelease {
+        ~RecordRelease() {
+            if (Detail::threadRecord != nullptr) {
+                Detail::threadRecord->used.store(false, std::memory_order_release);
+                Detail::threadRecord = nullptr;
+            }
+        }
+    };
+}
+
+Detail::EpochRecord* Detail::AcquireEpochRecord() {
+    std::call_once(barrierInit, InitBarrier);
+    thread_local RecordRelease release;
+
+    std::lock_guard lock(recordMutex);
+    EpochRecord* record = records;
+    while (record != nullptr && record->used.exchange(true, std::memory_order_acquire)) {
+        record = record->next;
+    }
+    if (record == nullptr) {
+        record = new EpochRecord;
+        record->used.store(true, std::memory_order_relaxed);
+        record->next = records;
+        records = record;
+    }
+    threadRecord = record;
+    return record;
+}
+
+void Detail::LockRecordsForFork() {
+    recordMutex.lock();
+}
+
+void Detail::UnlockRecordsAfterFork(const bool child) {
+    if (child) {
+        // only the forking thread exists, a call other threads had in flight never returns here
+        for (EpochRecord* record = records; record != nullptr; record = record->next) {
+            if (record != threadRecord) {
+                record->active.store(0, std::memory_order_relaxed);
+                record->nesting = 0;
+                record->used.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+    ReleaseAfterFork(recordMutex, child);
+}
+
+void Detail::SynchronizeEpoch(const std::uint64_t target) {
+    std::call_once(barrierInit, InitBarrier);
+    HeavyBarrier();
+
+    std::lock_guard lock(recordMutex);
+    for (const EpochRecord* record = records; record != nullptr; record = record->next) {
+        if (record == threadRecord) {
+            continue;
+        }
+        for (;;) {
+            const std::uint64_t active = record->active.load(std::memory_order_acquire);
+            if (active == 0 || active >= target) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
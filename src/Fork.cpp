@@ -0,0 +1,58 @@
+//
+// Created by DS on 2025/12/19.
+//
+
+#include <mutex>
+#include "internal/Fork.h"
+#include "internal/CacheManager.h"
+#include "internal/LibraryWatcher.h"
+#include "internal/SymbolCache.h"
+#include "internal/Telemetry.h"
+#include "internal/Trace.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+#ifdef __linux__
+namespace {
+    // the watcher reloads after releasing its mutex, it never waits for the others under it
+    void LockRegistry() {
+        Detail::LibraryWatcher::instance().lockForFork();
+        Detail::LockRecordsForFork();
+        Detail::CacheManager::instance().lockForFork();
+        Detail::loaderMutex.lock(); // after the shards, symbol lookup falls back to dlsym under them
+        Detail::LockNamesForFork();
+        Detail::LockIndexForFork();
+        Detail::LockOptionsForFork();
+        // leaves: taken under the locks above, never the other way round
+        Detail::SymbolCache::LockAllForFork();
+        Detail::LockTelemetryForFork();
+        Detail::LockTraceForFork();
+    }
+
+    void UnlockRegistry(const bool child) {
+        Detail::UnlockTraceAfterFork(child);
+        Detail::UnlockTelemetryAfterFork(child);
+        Detail::SymbolCache::UnlockAllAfterFork(child);
+        Detail::UnlockOptionsAfterFork(child);
+        Detail::UnlockIndexAfterFork(child);
+        Detail::UnlockNamesAfterFork(child);
+        Detail::ReleaseAfterFork(Detail::loaderMutex, child);
+        Detail::CacheManager::instance().unlockAfterFork(child);
+        Detail::UnlockRecordsAfterFork(child);
+        Detail::LibraryWatcher::instance().unlockAfterFork(child);
+    }
+}
+#endif
+
+void Detail::InstallForkHandlers() {
+#ifdef __linux__
+    static std::once_flag installed;
+    std::call_once(installed, [] {
+        // the singletons exist before a handler first runs
+        LibraryWatcher::instance();
+        pthread_atfork(LockRegistry, [] { UnlockRegistry(false); }, [] { UnlockRegistry(true); });
+    });
+#endif
+}
@@ -4,32 +4,43 @@
 
 //***** FunctionDescriptor's Implement *****
 
-#include "internal//DynamicLinkImpl.h"
+#include <iostream>
+#include "internal//DescriptorTable.h"
+#include "internal//Telemetry.h"
 
-Detail::FunctionDescriptor::FunctionDescriptor() {
-    this->functionPointer = 0;
+Detail::DescriptorHandle
+Detail::DescriptorTable::allocate(const uintptr_t function) {
+    std::lock_guard lock(this->mutex);
+    std::uint32_t index;
+    if (!this->freeList.empty()) {
+        index = this->freeList.back();
+        this->freeList.pop_back();
+        ResetFunctionTelemetry(index);
+    } else {
+        if (this->next == chunkSize * chunkCount) {
+            std::cerr << "descriptor table exhausted";
+            std::terminate();
+        }
+        index = this->next++;
+        if (index % chunkSize == 0) {
+            this->chunks[index / chunkSize].store(new FunctionDescriptor[chunkSize], std::memory_order_release);
+        }
+    }
+    FunctionDescriptor& descriptor = this->at(index);
+    descriptor.functionPointer.store(function, std::memory_order_release);
+    return {index, descriptor.generation.load(std::memory_order_relaxed)};
 }
 
-Detail::FunctionDescriptor::FunctionDescriptor(const uintptr_t funcPtr){
-    this->functionPointer = funcPtr;
+void Detail::DescriptorTable::release(const DescriptorHandle handle) {
+    if (!handle.valid()) {
+        return;
+    }
+    std::lock_guard lock(this->mutex);
+    FunctionDescriptor& descriptor = this->at(handle.index);
+    if (descriptor.generation.load(std::memory_order_relaxed) != handle.generation) {
+        return;
+    }
+    descriptor.functionPointer.store(0, std::memory_order_release);
+    descriptor.generation.store(handle.generation + 1, std::memory_order_release);
+    this->freeList.push_back(handle.index);
 }
-
-Detail::FunctionDescriptor::FunctionDescriptor(const FunctionDescriptor &other)  noexcept {
-    this->functionPointer = other.functionPointer;
-}
-
-Detail::FunctionDescriptor &
-Detail::FunctionDescriptor::operator=(FunctionDescriptor &&other) noexcept {
-    this->functionPointer = other.functionPointer;
-    return *this;
-}
-Detail::FunctionDescriptor &
-Detail::FunctionDescriptor::operator=(const FunctionDescriptor& other) noexcept {
-    this->functionPointer = other.functionPointer;
-    return *this;
-}
-
-Detail::FunctionDescriptor &Detail::FunctionDescriptor::operator=(const uintptr_t funcPtr) {
-    this->functionPointer = funcPtr;
-    return *this;
-}
\ No newline at end of file
@@ -0,0 +1,120 @@
+//
+// Created by DS on 2025/12/15.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "internal/HugePages.h"
+#include "internal/LoadOptions.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+#ifdef __linux__
+    constexpr uintptr_t hugePageSize = 2U << 20;
+
+    // executable segments of the image
+    std::vector<Detail::ImageSegment> TextSegments(const LHANDLE handle) {
+        auto segments = Detail::ImageSegments(handle);
+        std::erase_if(segments, [](const Detail::ImageSegment& segment) { return !segment.executable; });
+        return segments;
+    }
+
+    bool TransparentHugePagesAvailable() {
+        static const bool available = [] {
+            std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+            std::string mode;
+            return std::getline(file, mode) && mode.find("[never]") == std::string::npos;
+        }();
+        return available;
+    }
+
+    // anonymous memory starting on a huge page boundary
+    void* MapAligned(const std::size_t length) {
+        void* memory = mmap(nullptr, length + hugePageSize, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return nullptr;
+        }
+        const auto begin = reinterpret_cast<uintptr_t>(memory);
+        const uintptr_t aligned = (begin + hugePageSize - 1) & ~(hugePageSize - 1);
+        if (aligned != begin) {
+            munmap(memory, aligned - begin);
+        }
+        if (const uintptr_t tail = begin + length + hugePageSize - (aligned + length); tail != 0) {
+            munmap(reinterpret_cast<void*>(aligned + length), tail);
+        }
+        return reinterpret_cast<void*>(aligned);
+    }
+#endif
+}
+
+std::size_t Detail::RemapTextToHugePages(const LHANDLE handle) {
+#ifdef __linux__
+    if (!TransparentHugePagesAvailable()) {
+        return 0;
+    }
+    std::size_t remapped = 0;
+    for (const auto& segment : TextSegments(handle)) {
+        const uintptr_t first = (segment.begin + hugePageSize - 1) & ~(hugePageSize - 1);
+        const uintptr_t last = segment.end & ~(hugePageSize - 1);
+        if (first >= last) {
+            continue; // no whole huge page inside the segment
+        }
+        const std::size_t length = last - first;
+        void* copy = MapAligned(length);
+        if (copy == nullptr) {
+            continue;
+        }
+        madvise(copy, length, MADV_HUGEPAGE);
+        std::memcpy(copy, reinterpret_cast<const void*>(first), length);
+#ifdef MADV_COLLAPSE
+        madvise(copy, length, MADV_COLLAPSE); // best effort, khugepaged collapses it later otherwise
+#endif
+        // the copy replaces the file backed text in one step, the range never has a hole
+        if (mprotect(copy, length, PROT_READ | PROT_EXEC) != 0
+            || mremap(copy, length, length, MREMAP_MAYMOVE | MREMAP_FIXED,
+                reinterpret_cast<void*>(first)) == MAP_FAILED) {
+            munmap(copy, length);
+            continue;
+        }
+        remapped += length;
+    }
+    return remapped;
+#else
+    static_cast<void>(handle);
+    return 0;
+#endif
+}
+
+std::size_t Detail::HugePageTextBytes(const LHANDLE handle) {
+#ifdef __linux__
+    const auto ranges = TextSegments(handle);
+    if (ranges.empty()) {
+        return 0;
+    }
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool inside = false;
+    std::size_t bytes = 0;
+    while (std::getline(smaps, line)) {
+        if (uintptr_t begin, end; std::sscanf(line.c_str(), "%lx-%lx ", &begin, &end) == 2) {
+            inside = false;
+            for (const auto& range : ranges) {
+                inside = inside || (begin < range.end && range.begin < end);
+            }
+        } else if (std::size_t kilobytes; inside && std::sscanf(line.c_str(), "AnonHugePages: %zu kB", &kilobytes) == 1) {
+            bytes += kilobytes * 1024;
+        }
+    }
+    return bytes;
+#else
+    static_cast<void>(handle);
+    return 0;
+#endif
+}
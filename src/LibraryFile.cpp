@@ -1,10 +1,21 @@
 //
 // Created by DS on 2025/11/24.
 
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 #include <vector>
+#include "internal/Fork.h"
 #include "internal/LibraryFile.h"
 #include "internal/Platforms.h"
 #ifdef __linux__
+#include <climits>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
 const std::string prefix(PREFIX);
 #endif
 
@@ -13,60 +24,312 @@ const std::string suffix(SUFFIX);
 const std::string systemSearchPath(SYSTEM_PATH);
 std::vector<Detail::path> searchPaths;
 
-bool Detail::IsFullName(const std::string_view name) {
+// Every directory a library may come from is listed once and kept as name -> path,
+// resolving a library is a hash lookup. The index is rebuilt when a search path is
+// added, when a watched directory changes, or when a lookup misses and a directory
+// mtime (or the working directory) differs from the last scan.
+namespace {
+    struct ScannedDirectory {
+        Detail::path directory;
+        std::filesystem::file_time_type modified;
+    };
+
+    std::shared_mutex indexMutex;
+    std::unordered_map<std::string, Detail::path> libraryIndex;
+    std::vector<ScannedDirectory> scannedDirectories;
+    Detail::path scannedWorkingDirectory;
+    std::unordered_map<std::string, int> memoryLibraries; //< full name -> memfd, kept open for reloads
+    std::atomic<bool> indexStale{true};
+    bool seedLoaderCache = false;
+#ifdef __linux__
+    std::atomic<int> directoryWatch{-1}; //< inotify descriptor over `scannedDirectories`, never closed
+#endif
+
+    std::filesystem::file_time_type ModifiedTime(const Detail::path& directory) {
+        std::error_code error;
+        const auto time = std::filesystem::last_write_time(directory, error);
+        return error ? std::filesystem::file_time_type::min() : time;
+    }
+
+    // earlier directories win, like the probing order before the index
+    void IndexDirectory(const Detail::path& directory) {
+        std::error_code error;
+        scannedDirectories.push_back({directory, ModifiedTime(directory)});
+        for (std::filesystem::directory_iterator entry(directory, error), end;
+            !error && entry != end; entry.increment(error)) {
+            if (std::error_code typeError; entry->is_regular_file(typeError)) {
+                libraryIndex.try_emplace(entry->path().filename().string(), directory / entry->path().filename());
+            }
+        }
+    }
+
+#ifdef __linux__
+    // entry flags the loader accepts from ld.so.cache for this process: plain FLAG_ELF or
+    // FLAG_ELF_LIBC6 with the ABI bits of the target (_DL_CACHE_DEFAULT_ID)
+#if defined(__x86_64__) && defined(__ILP32__)
+    constexpr std::int32_t cacheAbi = 0x0803; // FLAG_X8664_LIBX32
+#elif defined(__x86_64__)
+    constexpr std::int32_t cacheAbi = 0x0303; // FLAG_X8664_LIB64
+#elif defined(__aarch64__)
+    constexpr std::int32_t cacheAbi = 0x0a03; // FLAG_AARCH64_LIB64
+#elif defined(__powerpc64__)
+    constexpr std::int32_t cacheAbi = 0x0503; // FLAG_POWERPC_LIB64
+#elif defined(__s390x__)
+    constexpr std::int32_t cacheAbi = 0x0403; // FLAG_S390_LIB64
+#elif defined(__riscv) && defined(__riscv_float_abi_double)
+    constexpr std::int32_t cacheAbi = 0x1003; // FLAG_RISCV_FLOAT_ABI_DOUBLE
+#elif defined(__arm__) && defined(__ARM_PCS_VFP)
+    constexpr std::int32_t cacheAbi = 0x0903; // FLAG_ARM_LIBHF
+#else
+    constexpr std::int32_t cacheAbi = 0x0003;
+#endif
+    constexpr std::int32_t cacheElf = 0x0001;
+
+    // sonames of /etc/ld.so.cache, the "glibc-ld.so.cache1.1" layout with or without
+    // the old "ld.so-1.7.0" table in front
+    void IndexLoaderCache() {
+        std::ifstream file("/etc/ld.so.cache", std::ios::binary);
+        const std::string cache{std::istreambuf_iterator(file), std::istreambuf_iterator<char>()};
+        constexpr std::string_view oldMagic = "ld.so-1.7.0", newMagic = "glibc-ld.so.cache1.1";
+        std::size_t start = 0;
+        if (cache.starts_with(oldMagic) && cache.size() >= 16) {
+            std::uint32_t oldCount;
+            std::memcpy(&oldCount, cache.data() + 12, sizeof(oldCount));
+            start = (16 + static_cast<std::size_t>(oldCount) * 12 + 7) & ~std::size_t{7};
+        }
+        struct Header {
+            char magic[20];
+            std::uint32_t count;
+            std::uint32_t stringsSize;
+            std::uint8_t flags;
+            std::uint8_t padding[3];
+            std::uint32_t extension;
+            std::uint32_t unused[3];
+        };
+        struct Entry {
+            std::int32_t flags;
+            std::uint32_t key;
+            std::uint32_t value;
+            std::uint32_t osVersion;
+            std::uint64_t hardwareCapabilities;
+        };
+        if (start + sizeof(Header) > cache.size()
+            || std::string_view(cache).substr(start, newMagic.size()) != newMagic) {
+            return;
+        }
+        Header header;
+        std::memcpy(&header, cache.data() + start, sizeof(header));
+        const std::string_view strings(cache.data() + start, cache.size() - start);
+        for (std::uint32_t i = 0; i < header.count; ++i) {
+            const std::size_t offset = start + sizeof(Header) + i * sizeof(Entry);
+            if (offset + sizeof(Entry) > cache.size()) {
+                break;
+            }
+            Entry entry;
+            std::memcpy(&entry, cache.data() + offset, sizeof(entry));
+            // other ABIs (lib32, x32) share sonames with ours; hwcaps variants come first but
+            // may not run on this CPU, the generic entry of the same name follows them
+            if ((entry.flags != cacheAbi && entry.flags != cacheElf) || entry.hardwareCapabilities != 0
+                || entry.key >= strings.size() || entry.value >= strings.size()) {
+                continue;
+            }
+            const auto key = strings.substr(entry.key, strings.find('\0', entry.key) - entry.key);
+            const auto value = strings.substr(entry.value, strings.find('\0', entry.value) - entry.value);
+            libraryIndex.try_emplace(std::string(key), Detail::path(value));
+        }
+    }
+
+    void WatchDirectories() {
+        if (directoryWatch.load(std::memory_order_relaxed) < 0) {
+            directoryWatch.store(inotify_init1(IN_NONBLOCK | IN_CLOEXEC), std::memory_order_release);
+        }
+        if (const int watch = directoryWatch.load(std::memory_order_relaxed); watch >= 0) {
+            // watches of directories dropped from the index only cost a spurious rebuild
+            for (const auto& scanned : scannedDirectories) {
+                inotify_add_watch(watch, scanned.directory.c_str(),
+                    IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+            }
+        }
+    }
+
+    // drains pending events, true when a watched directory changed
+    bool DirectoriesNotified() {
+        alignas(inotify_event) char events[4096];
+        bool changed = false;
+        const int watch = directoryWatch.load(std::memory_order_acquire);
+        while (watch >= 0 && read(watch, events, sizeof(events)) > 0) {
+            changed = true;
+        }
+        return changed;
+    }
+#endif
+
+    bool WorkingDirectoryMoved() {
+#ifdef __linux__
+        // no allocation, runs on every lookup that hits the working directory
+        char directory[PATH_MAX];
+        return getcwd(directory, sizeof(directory)) == nullptr || scannedWorkingDirectory.native() != directory;
+#else
+        std::error_code error;
+        return std::filesystem::current_path(error) != scannedWorkingDirectory;
+#endif
+    }
+
+    bool DirectoriesModified() {
+        if (WorkingDirectoryMoved()) {
+            return true;
+        }
+        for (const auto& [directory, modified] : scannedDirectories) {
+            if (ModifiedTime(directory) != modified) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // caller holds `indexMutex` exclusively
+    void RebuildIndex() {
+        libraryIndex.clear();
+        scannedDirectories.clear();
+        std::error_code error;
+        scannedWorkingDirectory = std::filesystem::current_path(error);
+        // absolute, so a hit can be told apart and checked against a later chdir
+        IndexDirectory(scannedWorkingDirectory.empty() ? Detail::path(".") : scannedWorkingDirectory);
+        IndexDirectory(systemSearchPath);
+        for (const auto& searchPath : searchPaths) {
+            IndexDirectory(searchPath);
+        }
+#ifdef __linux__
+        if (seedLoaderCache) {
+            IndexLoaderCache();
+        }
+        WatchDirectories();
+#endif
+        indexStale.store(false, std::memory_order_release);
+    }
+
+    std::optional<Detail::path> FindIndexed(const std::string& name) {
+        if (const auto file = libraryIndex.find(name); file != libraryIndex.end()) {
+            return file->second;
+        }
+        return std::nullopt;
+    }
+}
+
+#ifdef __linux__
+namespace {
+    // sonames carry their version after the suffix, e.g. libm.so.6 or libfoo.so.1.2
+    bool HasVersionedSuffix(const std::string_view name) {
+        const auto position = name.rfind(suffix + '.');
+        if (position == std::string_view::npos) {
+            return false;
+        }
+        const auto version = name.substr(position + suffix.size() + 1);
+        return !version.empty() && version.find_first_not_of("0123456789.") == std::string_view::npos;
+    }
+}
+#endif
+
+bool Detail::IsFullName(std::string_view name) {
+    // only the file name carries the prefix, e.g. shadow copies of a watched library
+    if (const auto separator = name.find_last_of("/\\"); separator != std::string_view::npos)
+        name.remove_prefix(separator + 1);
 #ifdef _WIN32
     return name.ends_with(suffix);
 #elif defined __linux__
-    return name.starts_with(prefix) && name.ends_with(suffix);
+    return name.starts_with(prefix) && (name.ends_with(suffix) || HasVersionedSuffix(name));
 #endif
 }
 
 std::string Detail::GetFullName(const std::string &name) {
+    if (const path file(name); file.has_parent_path())
+        return (file.parent_path() / GetFullName(file.filename().string())).string();
 #ifdef _WIN32
     if (!name.ends_with(suffix))
         return name + suffix;
     return name;
 
 #elif defined __linux__
-    auto fullName = name
+    auto fullName = name;
     if (!name.starts_with(prefix))
         fullName = prefix + fullName;
-    if (!name.ends_with(suffix))
-        fullname = fullName + suffix;
+    if (!name.ends_with(suffix) && !HasVersionedSuffix(name))
+        fullName = fullName + suffix;
     return fullName;
 #endif
 }
 
+std::pair<std::string, bool> Detail::SplitInstance(const std::string &name) {
+    if (const auto separator = name.rfind(instanceSeparator); separator != std::string::npos) {
+        return {name.substr(0, separator), true};
+    }
+    return {name, false};
+}
+
 void Detail::AddSearchPath(const std::string &path) {
     const Detail::path searchPath(path);
-    if (is_directory(searchPath))
+    if (std::error_code error; is_directory(searchPath, error)) {
+        std::unique_lock lock(indexMutex);
         searchPaths.push_back(searchPath);
+        indexStale.store(true, std::memory_order_release);
+    }
+}
+
+void Detail::UseLoaderCache(const bool enable) {
+    std::unique_lock lock(indexMutex);
+    seedLoaderCache = enable;
+    indexStale.store(true, std::memory_order_release);
 }
 
 std::optional<Detail::path> Detail::GetLibraryPath(const std::string &name) {
-    if (path fullPath("./" + name); is_regular_file(fullPath))
-        return fullPath;
-    if (path fullPath(systemSearchPath + name); is_regular_file(fullPath))
-        return fullPath;
-    if (!searchPaths.empty()) {
-        for (auto& searchPath : searchPaths) {
-            if (path fullPath(searchPath / name); is_regular_file(fullPath))
-                return fullPath;
+    {
+        std::shared_lock lock(indexMutex);
+        if (const auto image = memoryLibraries.find(name); image != memoryLibraries.end()) {
+            return path(std::format("/proc/self/fd/{}", image->second));
         }
     }
-    return std::nullopt;
+    // an explicit location is not looked up
+    if (const path file(name); file.has_parent_path()) {
+        if (std::error_code error; is_regular_file(file, error))
+            return file;
+        return std::nullopt;
+    }
+#ifdef __linux__
+    if (DirectoriesNotified())
+        indexStale.store(true, std::memory_order_release);
+#endif
+    if (!indexStale.load(std::memory_order_acquire)) {
+        std::shared_lock lock(indexMutex);
+        // a hit in the working directory only holds while the process stays there
+        if (auto file = FindIndexed(name);
+            file && (file->parent_path() != scannedWorkingDirectory || !WorkingDirectoryMoved()))
+            return file;
+    }
+    std::unique_lock lock(indexMutex);
+    if (indexStale.load(std::memory_order_acquire) || DirectoriesModified())
+        RebuildIndex();
+    return FindIndexed(name);
 }
 
-bool Detail::IsValidPath(const std::string &name) {
-    if (const path fullPath("." + name); is_regular_file(fullPath))
-        return true;
-    if (const path fullPath(systemSearchPath + name); is_regular_file(fullPath))
-        return true;
-    if (!searchPaths.empty()) {
-        for (auto& searchPath : searchPaths) {
-            if (const path fullPath(searchPath / name); is_regular_file(fullPath))
-                return true;
-        }
+void Detail::AddMemoryLibrary(const std::string &fullName, const int file) {
+    std::unique_lock lock(indexMutex);
+    if (const auto [image, inserted] = memoryLibraries.try_emplace(fullName, file); !inserted) {
+        // the loaded image stays mapped, only new loads see the replacement
+#ifdef __linux__
+        close(image->second);
+#endif
+        image->second = file;
     }
-    return false;
-}
\ No newline at end of file
+}
+
+bool Detail::IsValidPath(const std::string &name) {
+    return GetLibraryPath(name).has_value();
+}
+
+void Detail::LockIndexForFork() {
+    indexMutex.lock();
+}
+
+void Detail::UnlockIndexAfterFork(const bool child) {
+    ReleaseAfterFork(indexMutex, child);
+}
@@ -0,0 +1,233 @@
+//
+// Created by DS on 2025/12/12.
+//
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include "internal/Fork.h"
+#include "internal/LibraryWatcher.h"
+#include "internal/CacheManager.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+Detail::LibraryWatcher::LibraryWatcher() {
+    // reloads go through the cache, it has to outlive the watcher thread
+    CacheManager::instance();
+}
+
+Detail::LibraryWatcher::~LibraryWatcher() {
+    if (this->thread.joinable()) {
+        this->thread.request_stop();
+        this->thread.join();
+    }
+#ifdef __linux__
+    if (this->notify >= 0) {
+        close(this->notify);
+    }
+#endif
+    // the copies stay mapped, only the files go away
+    if (!this->shadowDirectory.empty()) {
+        std::error_code error;
+        std::filesystem::remove_all(this->shadowDirectory, error);
+    }
+}
+
+#ifdef __linux__
+
+void Detail::LibraryWatcher::watch(const LibraryId lib, const std::chrono::milliseconds debounce) {
+    const auto source = GetLibraryPath(GetFullName(NameOf(lib)));
+    if (!source) {
+        std::cerr << std::format("lib {} does not exist", NameOf(lib));
+        std::terminate();
+    }
+    std::lock_guard lock(this->mutex);
+    if (std::ranges::any_of(this->libraries, [lib](const auto& watched) { return watched.library == lib; })) {
+        return;
+    }
+    if (this->notify < 0) {
+        this->notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (this->notify < 0) {
+            std::cerr << "failed at watching libraries, inotify is unavailable";
+            std::terminate();
+        }
+    }
+    // editors and linkers replace the file, so the directory is watched rather than the inode
+    const path directory = source->has_parent_path() ? source->parent_path() : path(".");
+    const int watch = inotify_add_watch(this->notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (watch < 0) {
+        std::cerr << std::format("failed at watching {}", directory.string());
+        std::terminate();
+    }
+    this->directories.emplace(watch, directory);
+    this->libraries.push_back({lib, *source, watch, debounce});
+    if (!this->thread.joinable()) {
+        this->thread = std::jthread([this](const std::stop_token& stop) { this->run(stop); });
+    }
+}
+
+void Detail::LibraryWatcher::run(const std::stop_token& stop) {
+    alignas(inotify_event) char events[4096];
+    while (!stop.stop_requested()) {
+        auto timeout = std::chrono::milliseconds(100); // bounds how long a stop request waits
+        {
+            std::lock_guard lock(this->mutex);
+            for (const auto& watched : this->libraries) {
+                if (watched.due) {
+                    timeout = std::clamp(std::chrono::ceil<std::chrono::milliseconds>(*watched.due - Clock::now()),
+                        std::chrono::milliseconds(0), timeout);
+                }
+            }
+        }
+        pollfd descriptor{this->notify, POLLIN, 0};
+        poll(&descriptor, 1, static_cast<int>(timeout.count()));
+
+        struct DueReload {
+            LibraryId library;
+            path source;
+            path shadow;
+        };
+        std::vector<DueReload> due;
+        {
+            std::lock_guard lock(this->mutex);
+            for (ssize_t size; (size = read(this->notify, events, sizeof(events))) > 0;) {
+                for (ssize_t offset = 0; offset < size;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(events + offset);
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                    const auto directory = this->directories.find(event->wd);
+                    if (event->len == 0 || directory == this->directories.end()) {
+                        continue;
+                    }
+                    // every write pushes the reload back, a build is picked up once it is quiet
+                    for (auto& watched : this->libraries) {
+                        if (watched.source.filename() == event->name && watched.source.parent_path() == directory->second) {
+                            watched.due = Clock::now() + watched.debounce;
+                        }
+                    }
+                }
+            }
+            const auto now = Clock::now();
+            for (auto& watched : this->libraries) {
+                if (watched.due && *watched.due <= now) {
+                    watched.due.reset();
+                    due.push_back({watched.library, watched.source, this->shadowOf(watched.source)});
+                }
+            }
+        }
+        // the reload takes the cache locks and runs hooks, never under the watcher's mutex
+        for (const auto& [library, source, shadow] : due) {
+            if (!this->reload(library, source, shadow)) {
+                continue;
+            }
+            std::lock_guard lock(this->mutex);
+            const auto watched = std::ranges::find(this->libraries, library, &WatchedLibrary::library);
+            if (watched == this->libraries.end()) {
+                continue; // unwatched meanwhile, the copy goes with the shadow directory
+            }
+            std::error_code error;
+            if (!watched->shadow.empty()) {
+                std::filesystem::remove(watched->shadow, error);
+            }
+            watched->shadow = shadow;
+        }
+    }
+}
+
+Detail::path Detail::LibraryWatcher::shadowOf(const path& source) {
+    std::error_code error;
+    if (this->shadowDirectory.empty()) {
+        this->shadowDirectory = std::filesystem::temp_directory_path(error) / std::format("DynamicLink-{}", getpid());
+        std::filesystem::create_directories(this->shadowDirectory, error);
+    }
+    return this->shadowDirectory / std::format("{}.{}{}",
+        source.stem().string(), ++this->shadowCount, source.extension().string());
+}
+
+bool Detail::LibraryWatcher::reload(const LibraryId lib, const path& source, const path& shadow) {
+    auto& cache = CacheManager::instance();
+    const LibraryId current = cache.getNewName(lib);
+    if (!cache.containsLibrary(current)) {
+        return false; // not loaded, the next load reads the new file anyway
+    }
+    std::error_code error;
+    if (!std::filesystem::copy_file(source, shadow, std::filesystem::copy_options::overwrite_existing, error)) {
+        std::cerr << std::format("failed at copying {} for reloading: {}\n", source.string(), error.message());
+        return false;
+    }
+    if (!cache.reloadLibrary(current, InternName(shadow.string()))) {
+        std::filesystem::remove(shadow, error); // refused by a reload hook, the old copy stays
+        return false;
+    }
+    return true;
+}
+
+#else
+
+void Detail::LibraryWatcher::watch(const LibraryId lib, std::chrono::milliseconds) {
+    std::cerr << std::format("failed at watching {}, automatic reload needs inotify", NameOf(lib));
+    std::terminate();
+}
+
+void Detail::LibraryWatcher::run(const std::stop_token&) {}
+
+Detail::path Detail::LibraryWatcher::shadowOf(const path&) {
+    return {};
+}
+
+bool Detail::LibraryWatcher::reload(LibraryId, const path&, const path&) {
+    return false;
+}
+
+#endif
+
+void Detail::LibraryWatcher::unwatch(const LibraryId lib) {
+    std::lock_guard lock(this->mutex);
+    const auto watched = std::ranges::find(this->libraries, lib, &WatchedLibrary::library);
+    if (watched == this->libraries.end()) {
+        return;
+    }
+    const int directory = watched->directory;
+    this->libraries.erase(watched);
+#ifdef __linux__
+    // libraries of the same directory share its watch
+    if (std::ranges::find(this->libraries, directory, &WatchedLibrary::directory) == this->libraries.end()) {
+        inotify_rm_watch(this->notify, directory);
+        this->directories.erase(directory);
+    }
+#endif
+}
+
+void Detail::LibraryWatcher::lockForFork() {
+    this->mutex.lock();
+}
+
+void Detail::LibraryWatcher::unlockAfterFork(const bool child) {
+    if (child) {
+        if (this->thread.joinable()) {
+            this->thread.detach();
+        }
+#ifdef __linux__
+        // shared with the parent, reading it here would steal the parent's events
+        if (this->notify >= 0) {
+            close(this->notify);
+            this->notify = -1;
+        }
+#endif
+        this->libraries.clear();
+        this->directories.clear();
+        this->shadowDirectory.clear();
+    }
+    ReleaseAfterFork(this->mutex, child);
+}
+
+void DynamicLink::WatchLibrary(const std::string &lib, const std::chrono::milliseconds debounce) {
+    Detail::LibraryWatcher::instance().watch(Detail::InternName(lib), debounce);
+}
+
+void DynamicLink::UnwatchLibrary(const std::string &lib) {
+    Detail::LibraryWatcher::instance().unwatch(Detail::InternName(lib));
+}
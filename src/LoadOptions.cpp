@@ -0,0 +1,151 @@
+//
+// Created by DS on 2025/12/16.
+//
+
+#include <cstring>
+#include <mutex>
+#include <ranges>
+#include <shared_mutex>
+#include <unordered_map>
+#include "internal/Fork.h"
+#include "internal/LibraryFile.h"
+#include "internal/LoadOptions.h"
+
+#ifdef __linux__
+#include <link.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::shared_mutex optionsMutex{};
+    std::unordered_map<Detail::LibraryId, DynamicLink::LoadOptions> libraryOptions{};
+    DynamicLink::LoadOptions defaultOptions{};
+}
+
+DynamicLink::LoadOptions Detail::GetLoadOptions(const LibraryId lib) {
+    std::shared_lock lock(optionsMutex);
+    if (const auto options = libraryOptions.find(lib); options != libraryOptions.end()) {
+        return options->second;
+    }
+    // an isolated instance falls back to the options of its library
+    if (const auto [name, isolated] = SplitInstance(NameOf(lib)); isolated) {
+        if (const auto options = libraryOptions.find(InternName(name)); options != libraryOptions.end()) {
+            return options->second;
+        }
+    }
+    return defaultOptions;
+}
+
+void Detail::SetLoadOptions(const LibraryId lib, const DynamicLink::LoadOptions& options) {
+    std::unique_lock lock(optionsMutex);
+    libraryOptions.insert_or_assign(lib, options);
+}
+
+void Detail::SetDefaultLoadOptions(const DynamicLink::LoadOptions& options) {
+    std::unique_lock lock(optionsMutex);
+    defaultOptions = options;
+}
+
+DynamicLink::LoadOptions Detail::GetDefaultLoadOptions() {
+    std::shared_lock lock(optionsMutex);
+    return defaultOptions;
+}
+
+void Detail::InheritLoadOptions(const LibraryId from, const LibraryId to) {
+    std::unique_lock lock(optionsMutex);
+    if (const auto options = libraryOptions.find(from); options != libraryOptions.end()) {
+        libraryOptions.try_emplace(to, options->second);
+    }
+}
+
+std::vector<Detail::LibraryId> Detail::ConfiguredLibraries() {
+    std::shared_lock lock(optionsMutex);
+    std::vector<LibraryId> libraries;
+    libraries.reserve(libraryOptions.size());
+    for (const auto lib : libraryOptions | std::views::keys) {
+        libraries.push_back(lib);
+    }
+    return libraries;
+}
+
+void Detail::LockOptionsForFork() {
+    optionsMutex.lock();
+}
+
+void Detail::UnlockOptionsAfterFork(const bool child) {
+    ReleaseAfterFork(optionsMutex, child);
+}
+
+int Detail::LoaderFlags(const DynamicLink::LoadOptions& options) {
+#ifdef __linux__
+    int flags = options.binding == DynamicLink::Binding::Now ? RTLD_NOW : RTLD_LAZY;
+    flags |= options.visibility == DynamicLink::Visibility::Global ? RTLD_GLOBAL : RTLD_LOCAL;
+    if (options.noDelete) {
+        flags |= RTLD_NODELETE;
+    }
+    if (options.deepBind) {
+        flags |= RTLD_DEEPBIND;
+    }
+    return flags;
+#else
+    static_cast<void>(options);
+    return 0;
+#endif
+}
+
+std::vector<Detail::ImageSegment> Detail::ImageSegments(const LHANDLE handle) {
+#ifdef __linux__
+    struct Search {
+        const link_map* map;
+        std::vector<ImageSegment> segments{};
+    } search{nullptr};
+    link_map* map = nullptr;
+    std::shared_lock loader(loaderMutex);
+    if (handle == nullptr || dlinfo(handle, RTLD_DI_LINKMAP, &map) != 0 || map == nullptr) {
+        return {};
+    }
+    search.map = map;
+    dl_iterate_phdr([](dl_phdr_info* info, std::size_t, void* data) {
+        auto* search = static_cast<Search*>(data);
+        if (info->dlpi_addr != search->map->l_addr || info->dlpi_name == nullptr
+            || std::strcmp(info->dlpi_name, search->map->l_name) != 0) {
+            return 0;
+        }
+        for (std::size_t i = 0; i < info->dlpi_phnum; ++i) {
+            if (const ElfW(Phdr)& header = info->dlpi_phdr[i]; header.p_type == PT_LOAD) {
+                const uintptr_t begin = info->dlpi_addr + header.p_vaddr;
+                search->segments.push_back({begin, begin + header.p_memsz, (header.p_flags & PF_X) != 0});
+            }
+        }
+        return 1;
+    }, &search);
+    return search.segments;
+#else
+    static_cast<void>(handle);
+    return {};
+#endif
+}
+
+void Detail::PrefaultImage(const LHANDLE handle) {
+#ifdef __linux__
+    static const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    for (const auto& segment : ImageSegments(handle)) {
+        const uintptr_t first = segment.begin & ~(page - 1);
+        auto* address = reinterpret_cast<void*>(first);
+        const std::size_t length = segment.end - first;
+#ifdef MADV_POPULATE_READ
+        if (madvise(address, length, MADV_POPULATE_READ) == 0) {
+            continue;
+        }
+#endif
+        // older kernels: start the read-ahead and touch every page
+        madvise(address, length, MADV_WILLNEED);
+        for (uintptr_t current = first; current < segment.end; current += page) {
+            static_cast<void>(*reinterpret_cast<const volatile char*>(current));
+        }
+    }
+#else
+    static_cast<void>(handle);
+#endif
+}
@@ -0,0 +1,172 @@
+//
+// Created by DS on 2025/12/11.
+//
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "DynamicLink.h"
+#include "internal/CacheManager.h"
+#include "internal/ElfFile.h"
+
+#define instance Detail::CacheManager::instance()
+
+namespace {
+    struct PreloadNode {
+        Detail::LibraryId library;
+        std::vector<Detail::SymbolId> functions{};
+        std::vector<std::string> needed{};     //< DT_NEEDED of the library file
+        std::vector<std::size_t> dependents{}; //< nodes of the batch that need this one
+        std::size_t pending{0};                //< dependencies of the batch not loaded yet
+        bool queued{false};
+    };
+
+    // One PreloadLibrariesAsync call. Files are scanned in parallel first, then every
+    // library is loaded as soon as the libraries it needs from the same batch are in.
+    class PreloadBatch {
+    public:
+        explicit PreloadBatch(std::span<const DynamicLink::PreloadRequest> requests) {
+            std::unordered_map<Detail::LibraryId, std::size_t> index;
+            for (const auto& request : requests) {
+                const auto lib = Detail::InternName(request.library);
+                const auto [node, inserted] = index.try_emplace(lib, this->nodes.size());
+                if (inserted) {
+                    this->nodes.push_back({lib});
+                }
+                for (const auto& function : request.functions) {
+                    this->nodes[node->second].functions.push_back(Detail::InternName(function));
+                }
+            }
+        }
+
+        void run() {
+            const std::size_t workers = std::clamp<std::size_t>(
+                std::thread::hardware_concurrency(), 1, std::max<std::size_t>(this->nodes.size(), 1));
+            {
+                std::vector<std::jthread> pool;
+                for (std::size_t i = 1; i < workers; ++i) {
+                    pool.emplace_back([this] { this->scan(); });
+                }
+                this->scan();
+            }
+            this->link();
+            std::vector<std::jthread> pool;
+            for (std::size_t i = 1; i < workers; ++i) {
+                pool.emplace_back([this] { this->load(); });
+            }
+            this->load();
+        }
+
+    private:
+        void scan() {
+            for (std::size_t i = this->scanned.fetch_add(1); i < this->nodes.size(); i = this->scanned.fetch_add(1)) {
+                auto& node = this->nodes[i];
+                if (instance.containsLibrary(node.library)) {
+                    continue;
+                }
+                if (const auto file = Detail::GetLibraryPath(Detail::GetFullName(Detail::NameOf(node.library)))) {
+                    Detail::PrefetchLibrary(*file);
+                    node.needed = Detail::ReadNeededLibraries(*file);
+                }
+            }
+        }
+
+        void link() {
+            std::unordered_map<std::string, std::size_t> byName;
+            for (std::size_t i = 0; i < this->nodes.size(); ++i) {
+                byName.emplace(Detail::GetFullName(Detail::NameOf(this->nodes[i].library)), i);
+            }
+            for (std::size_t i = 0; i < this->nodes.size(); ++i) {
+                for (const auto& needed : this->nodes[i].needed) {
+                    if (const auto dependency = byName.find(needed);
+                        dependency != byName.end() && dependency->second != i) {
+                        this->nodes[dependency->second].dependents.push_back(i);
+                        ++this->nodes[i].pending;
+                    }
+                }
+            }
+            for (std::size_t i = 0; i < this->nodes.size(); ++i) {
+                if (this->nodes[i].pending == 0) {
+                    this->nodes[i].queued = true;
+                    this->ready.push_back(i);
+                }
+            }
+            if (this->ready.empty()) {
+                this->breakCycle();
+            }
+        }
+
+        void load() {
+            std::unique_lock lock(this->mutex);
+            while (true) {
+                this->wake.wait(lock, [this] {
+                    return !this->ready.empty() || this->finished == this->nodes.size();
+                });
+                if (this->ready.empty()) {
+                    return;
+                }
+                const auto& node = this->nodes[this->ready.front()];
+                this->ready.pop_front();
+                ++this->running;
+                lock.unlock();
+
+                if (!instance.containsLibrary(node.library)) {
+                    instance(node.library, Detail::LoadLibraryWithCheck(Detail::NameOf(node.library)));
+                }
+                for (const auto function : node.functions) {
+                    instance.findFunction(node.library, function);
+                }
+
+                lock.lock();
+                --this->running;
+                ++this->finished;
+                for (const auto dependent : node.dependents) {
+                    auto& next = this->nodes[dependent];
+                    if (!next.queued && --next.pending == 0) {
+                        next.queued = true;
+                        this->ready.push_back(dependent);
+                    }
+                }
+                if (this->ready.empty() && this->running == 0 && this->finished < this->nodes.size()) {
+                    this->breakCycle();
+                }
+                this->wake.notify_all();
+            }
+        }
+
+        // libraries needing each other, the dynamic loader sorts them out itself
+        void breakCycle() {
+            for (std::size_t i = 0; i < this->nodes.size(); ++i) {
+                if (!this->nodes[i].queued) {
+                    this->nodes[i].queued = true;
+                    this->ready.push_back(i);
+                }
+            }
+        }
+
+        std::vector<PreloadNode> nodes;
+        std::atomic<std::size_t> scanned{0};
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<std::size_t> ready;
+        std::size_t running{0};
+        std::size_t finished{0};
+    };
+}
+
+std::future<void> DynamicLink::PreloadLibrariesAsync(const std::span<const PreloadRequest> requests) {
+    auto batch = std::make_unique<PreloadBatch>(requests);
+    return std::async(std::launch::async, [batch = std::move(batch)] { batch->run(); });
+}
+
+std::future<void> DynamicLink::PreloadLibrariesAsync(const std::span<const std::string> libs) {
+    std::vector<PreloadRequest> requests;
+    requests.reserve(libs.size());
+    for (const auto& lib : libs) {
+        requests.push_back({lib});
+    }
+    return PreloadLibrariesAsync(requests);
+}
@@ -0,0 +1,37 @@
+//
+// Created by DS on 2025/12/21.
+//
+
+#include <format>
+#include <iostream>
+#include "internal/ReloadState.h"
+#include "internal/Trace.h"
+
+bool Detail::HandOverState(const SymbolResolver& from, const SymbolResolver& to, const std::string_view library,
+    DynamicLink::ReloadState& handed) {
+    if (const auto warmup = reinterpret_cast<Warmup>(to(warmupHook.data())); warmup != nullptr) {
+        [[maybe_unused]] const TraceSpan span("warmup", library);
+        if (warmup() != 0) {
+            std::cerr << std::format("reload of {} aborted, warmup failed\n", library);
+            return false;
+        }
+    }
+    // last, nothing may fail after the new version took the state over
+    const auto exportState = reinterpret_cast<ExportState>(from(exportStateHook.data()));
+    const auto importState = reinterpret_cast<ImportState>(to(importStateHook.data()));
+    if (exportState != nullptr && importState != nullptr) {
+        [[maybe_unused]] const TraceSpan span("state handoff", library);
+        DynamicLink::ReloadState state{};
+        if (exportState(&state) != 0) {
+            std::cerr << std::format("reload of {} aborted, export_state failed\n", library);
+            return false;
+        }
+        if (importState(&state) != 0) {
+            std::cerr << std::format("reload of {} aborted, import_state failed\n", library);
+            return false;
+        }
+        // still the old version's memory unless the new one adopted it, the old one serves until retired
+        handed = state;
+    }
+    return true;
+}
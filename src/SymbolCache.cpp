@@ -0,0 +1,279 @@
+//
+// Created by DS on 2025/12/14.
+//
+
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <shared_mutex>
+#include <unordered_set>
+#include <vector>
+#include "internal/Fork.h"
+#include "internal/SymbolCache.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::shared_mutex directoryMutex;
+    Detail::path cacheDirectory;
+
+    std::mutex cachesMutex;
+    std::unordered_set<Detail::SymbolCache*> openCaches; //< only for the fork handlers
+
+    constexpr char magic[8] = {'D', 'L', 'S', 'Y', 'M', 'C', '1', '\0'};
+    constexpr std::size_t identityCapacity = 64;
+
+    // file layout: Header, `capacity` Slots (open addressing, hash 0 = empty), names
+    struct Header {
+        char magic[8];
+        std::uint32_t capacity;
+        std::uint32_t count;
+        std::uint32_t namesSize;
+        std::uint32_t identitySize;
+        char identity[identityCapacity];
+    };
+    struct Slot {
+        std::uint64_t hash;
+        std::uint32_t name;
+        std::uint32_t length;
+        std::uint64_t offset;
+    };
+
+    std::uint64_t Fnv(const std::string_view text) {
+        std::uint64_t hash = 14695981039346656037ULL;
+        for (const char c : text) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+        }
+        return hash | 1; // 0 marks an empty slot
+    }
+}
+
+void Detail::SetSymbolCacheDirectory(const path& directory) {
+    std::unique_lock lock(directoryMutex);
+    cacheDirectory = directory;
+    if (std::error_code error; !directory.empty()) {
+        std::filesystem::create_directories(directory, error);
+    }
+}
+
+std::shared_ptr<Detail::SymbolCache> Detail::SymbolCache::Open(const path& library, std::string identity) {
+    path directory;
+    {
+        std::shared_lock lock(directoryMutex);
+        directory = cacheDirectory;
+    }
+    if (directory.empty() || identity.empty() || identity.size() > identityCapacity) {
+        return nullptr;
+    }
+    std::error_code error;
+    const path absolute = std::filesystem::absolute(library, error);
+    const path file = directory / std::format("{}-{:016x}.symbols",
+        library.filename().string(), Fnv(absolute.string()));
+    return std::shared_ptr<SymbolCache>(new SymbolCache(file, std::move(identity)));
+}
+
+Detail::SymbolCache::SymbolCache(path file, std::string identity)
+    : file(std::move(file)), identity(std::move(identity)) {
+    this->map();
+    std::lock_guard lock(cachesMutex);
+    openCaches.insert(this);
+}
+
+Detail::SymbolCache::~SymbolCache() {
+    {
+        std::lock_guard lock(cachesMutex);
+        openCaches.erase(this);
+    }
+    this->flush();
+    this->unmap();
+}
+
+void Detail::SymbolCache::LockAllForFork() {
+    directoryMutex.lock();
+    cachesMutex.lock();
+    for (const SymbolCache* cache : openCaches) {
+        cache->mutex.lock();
+    }
+}
+
+void Detail::SymbolCache::UnlockAllAfterFork(const bool child) {
+    for (const SymbolCache* cache : openCaches) {
+        ReleaseAfterFork(cache->mutex, child);
+    }
+    ReleaseAfterFork(cachesMutex, child);
+    ReleaseAfterFork(directoryMutex, child);
+}
+
+std::optional<uintptr_t> Detail::SymbolCache::find(const std::string_view name) const {
+    if (this->mapped != nullptr) {
+        const auto* header = reinterpret_cast<const Header*>(this->mapped);
+        const auto* slots = reinterpret_cast<const Slot*>(header + 1);
+        const auto* names = reinterpret_cast<const char*>(slots + header->capacity);
+        const std::uint64_t hash = Fnv(name);
+        for (std::uint32_t probe = 0; probe < header->capacity; ++probe) {
+            const Slot& slot = slots[(hash + probe) & (header->capacity - 1)];
+            if (slot.hash == 0) {
+                break;
+            }
+            if (slot.hash == hash && std::string_view(names + slot.name, slot.length) == name) {
+                return slot.offset;
+            }
+        }
+    }
+    std::lock_guard lock(this->mutex);
+    if (const auto entry = this->recorded.find(std::string(name)); entry != this->recorded.end()) {
+        return entry->second;
+    }
+    return std::nullopt;
+}
+
+void Detail::SymbolCache::record(const std::string_view name, const uintptr_t offset) {
+    std::lock_guard lock(this->mutex);
+    this->dirty |= this->recorded.try_emplace(std::string(name), offset).second;
+}
+
+void Detail::SymbolCache::flush() {
+    std::lock_guard lock(this->mutex);
+    if (!this->dirty) {
+        return;
+    }
+    // merge with what the mapped file already knows
+    std::vector<std::pair<std::string_view, uintptr_t>> entries;
+    for (const auto& [name, offset] : this->recorded) {
+        entries.emplace_back(name, offset);
+    }
+    if (this->mapped != nullptr) {
+        const auto* header = reinterpret_cast<const Header*>(this->mapped);
+        const auto* slots = reinterpret_cast<const Slot*>(header + 1);
+        const auto* names = reinterpret_cast<const char*>(slots + header->capacity);
+        for (std::uint32_t i = 0; i < header->capacity; ++i) {
+            if (slots[i].hash != 0 && !this->recorded.contains(std::string(names + slots[i].name, slots[i].length))) {
+                entries.emplace_back(std::string_view(names + slots[i].name, slots[i].length), slots[i].offset);
+            }
+        }
+    }
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.capacity = 16;
+    while (header.capacity < entries.size() * 2) {
+        header.capacity *= 2;
+    }
+    header.count = static_cast<std::uint32_t>(entries.size());
+    header.identitySize = static_cast<std::uint32_t>(this->identity.size());
+    std::memcpy(header.identity, this->identity.data(), this->identity.size());
+    std::vector<Slot> slots(header.capacity);
+    std::string names;
+    for (const auto& [name, offset] : entries) {
+        const std::uint64_t hash = Fnv(name);
+        std::uint32_t index = hash & (header.capacity - 1);
+        while (slots[index].hash != 0) {
+            index = (index + 1) & (header.capacity - 1);
+        }
+        slots[index] = {hash, static_cast<std::uint32_t>(names.size()), static_cast<std::uint32_t>(name.size()), offset};
+        names.append(name);
+    }
+    header.namesSize = static_cast<std::uint32_t>(names.size());
+
+    // a crash leaves either the old file or the complete new one behind; forked workers
+    // share the cache object's address, the pid keeps their temporary files apart
+#ifdef __linux__
+    const int process = getpid();
+#else
+    const int process = 0;
+#endif
+    const path temporary = this->file.string()
+        + std::format(".{}.{}.tmp", process, reinterpret_cast<uintptr_t>(this));
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(Slot)));
+        out.write(names.data(), static_cast<std::streamsize>(names.size()));
+        out.flush();
+        if (!out) {
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+#ifdef __linux__
+    if (const int fd = open(temporary.c_str(), O_RDONLY | O_CLOEXEC); fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+    std::error_code error;
+    std::filesystem::rename(temporary, this->file, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+#ifdef __linux__
+    // the rename itself only survives a crash once the directory is on disk
+    if (const int fd = open(this->file.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC); fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+    this->dirty = false;
+}
+
+#ifdef __linux__
+
+void Detail::SymbolCache::map() {
+    const int fd = open(this->file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat status{};
+    if (fstat(fd, &status) == 0 && static_cast<std::size_t>(status.st_size) >= sizeof(Header)) {
+        void* address = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            this->mapped = static_cast<const unsigned char*>(address);
+            this->mappedSize = status.st_size;
+        }
+    }
+    close(fd);
+    if (this->mapped == nullptr) {
+        return;
+    }
+    // anything unexpected, most of all another build of the library, drops the file
+    const auto* header = reinterpret_cast<const Header*>(this->mapped);
+    const bool valid = std::memcmp(header->magic, magic, sizeof(magic)) == 0
+        && header->capacity != 0 && (header->capacity & (header->capacity - 1)) == 0
+        && header->capacity <= (this->mappedSize - sizeof(Header)) / sizeof(Slot)
+        && sizeof(Header) + header->capacity * sizeof(Slot) + header->namesSize == this->mappedSize
+        && std::string_view(header->identity, std::min<std::size_t>(header->identitySize, identityCapacity)) == this->identity;
+    if (!valid) {
+        this->unmap();
+        return;
+    }
+    const auto* slots = reinterpret_cast<const Slot*>(header + 1);
+    for (std::uint32_t i = 0; i < header->capacity; ++i) {
+        if (slots[i].hash != 0 && std::uint64_t{slots[i].name} + slots[i].length > header->namesSize) {
+            this->unmap();
+            return;
+        }
+    }
+}
+
+void Detail::SymbolCache::unmap() {
+    if (this->mapped != nullptr) {
+        munmap(const_cast<unsigned char*>(this->mapped), this->mappedSize);
+        this->mapped = nullptr;
+        this->mappedSize = 0;
+    }
+}
+
+#else
+
+void Detail::SymbolCache::map() {}
+
+void Detail::SymbolCache::unmap() {}
+
+#endif
@@ -0,0 +1,283 @@
+//
+// Created by DS on 2025/12/13.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include "internal/Fork.h"
+#include "internal/SymbolResolver.h"
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+
+namespace {
+    std::uint32_t GnuHash(const char* name) {
+        std::uint32_t hash = 5381;
+        for (auto c = static_cast<unsigned char>(*name); c != 0; c = static_cast<unsigned char>(*++name)) {
+            hash = hash * 33 + c;
+        }
+        return hash;
+    }
+
+    std::uint32_t SysvHash(const char* name) {
+        std::uint32_t hash = 0;
+        for (auto c = static_cast<unsigned char>(*name); c != 0; c = static_cast<unsigned char>(*++name)) {
+            hash = (hash << 4) + c;
+            hash ^= (hash >> 24) & 0xf0;
+        }
+        return hash & 0x0fffffff;
+    }
+
+    // build-id note of the loaded image, size and mtime of the file without one
+    std::string ImageIdentity(const link_map* map) {
+        struct Search {
+            const link_map* map;
+            std::string identity{};
+        } search{map};
+        std::shared_lock loader(Detail::loaderMutex);
+        dl_iterate_phdr([](dl_phdr_info* info, std::size_t, void* data) {
+            auto* search = static_cast<Search*>(data);
+            if (info->dlpi_addr != search->map->l_addr || info->dlpi_name == nullptr
+                || std::strcmp(info->dlpi_name, search->map->l_name) != 0) {
+                return 0;
+            }
+            for (std::size_t i = 0; i < info->dlpi_phnum; ++i) {
+                const ElfW(Phdr)& header = info->dlpi_phdr[i];
+                if (header.p_type != PT_NOTE) {
+                    continue;
+                }
+                const auto* note = reinterpret_cast<const unsigned char*>(info->dlpi_addr + header.p_vaddr);
+                const auto* end = note + header.p_memsz;
+                while (note + sizeof(ElfW(Nhdr)) <= end) {
+                    const auto* entry = reinterpret_cast<const ElfW(Nhdr)*>(note);
+                    const auto* name = note + sizeof(ElfW(Nhdr));
+                    const auto* description = name + ((entry->n_namesz + 3) & ~3U);
+                    if (entry->n_type == NT_GNU_BUILD_ID && entry->n_namesz == 4
+                        && std::memcmp(name, "GNU", 4) == 0 && description + entry->n_descsz <= end) {
+                        search->identity = "build-id:";
+                        for (std::size_t byte = 0; byte < entry->n_descsz; ++byte) {
+                            search->identity += std::format("{:02x}", description[byte]);
+                        }
+                        return 1;
+                    }
+                    note = description + ((entry->n_descsz + 3) & ~3U);
+                }
+            }
+            return 1;
+        }, &search);
+        if (search.identity.empty()) {
+            if (struct stat status{}; stat(map->l_name, &status) == 0) {
+                search.identity = std::format("stat:{}:{}.{}", status.st_size,
+                    status.st_mtim.tv_sec, status.st_mtim.tv_nsec);
+            }
+        }
+        return search.identity;
+    }
+
+    constexpr std::uint16_t hiddenVersion = 0x8000;
+}
+
+Detail::SymbolResolver::SymbolResolver(const LHANDLE handle) : handle(handle) {
+    link_map* map = nullptr;
+    {
+        std::shared_lock loader(loaderMutex);
+        if (handle == nullptr || dlinfo(handle, RTLD_DI_LINKMAP, &map) != 0) {
+            return;
+        }
+    }
+    if (map == nullptr || map->l_ld == nullptr) {
+        return;
+    }
+    this->base = map->l_addr;
+    // ld.so rebases the pointers in place unless the dynamic section is read only
+    const auto address = [this](const ElfW(Addr) pointer) {
+        return pointer < this->base ? pointer + this->base : pointer;
+    };
+    for (const ElfW(Dyn)* entry = map->l_ld; entry->d_tag != DT_NULL; ++entry) {
+        switch (entry->d_tag) {
+            case DT_SYMTAB:
+                this->symbols = reinterpret_cast<const ElfW(Sym)*>(address(entry->d_un.d_ptr));
+                break;
+            case DT_STRTAB:
+                this->strings = reinterpret_cast<const char*>(address(entry->d_un.d_ptr));
+                break;
+            case DT_VERSYM:
+                this->versions = reinterpret_cast<const std::uint16_t*>(address(entry->d_un.d_ptr));
+                break;
+            case DT_GNU_HASH:
+                this->gnuHash = reinterpret_cast<const std::uint32_t*>(address(entry->d_un.d_ptr));
+                break;
+            case DT_HASH:
+                this->sysvHash = reinterpret_cast<const std::uint32_t*>(address(entry->d_un.d_ptr));
+                break;
+            default:
+                break;
+        }
+    }
+    if (this->symbols == nullptr || this->strings == nullptr) {
+        this->gnuHash = this->sysvHash = nullptr;
+        return;
+    }
+    if (map->l_name != nullptr && map->l_name[0] != '\0') {
+        this->persistent = SymbolCache::Open(map->l_name, ImageIdentity(map));
+    }
+}
+
+uintptr_t Detail::SymbolResolver::operator()(const char* name) const {
+    if (this->persistent) {
+        if (const auto offset = this->persistent->find(name)) {
+            return this->base + *offset;
+        }
+    }
+    if (const auto index = this->find(name); index != 0) {
+        const ElfW(Sym)& symbol = this->symbols[index];
+        if (const auto type = ELF64_ST_TYPE(symbol.st_info); type != STT_GNU_IFUNC && type != STT_TLS) {
+            if (this->persistent) {
+                this->persistent->record(name, symbol.st_value);
+            }
+            return this->base + symbol.st_value;
+        }
+    }
+    if (this->handle == nullptr) {
+        return 0;
+    }
+    std::shared_lock loader(loaderMutex);
+    return GET_FUNC(this->handle, name);
+}
+
+bool Detail::SymbolResolver::exported(const std::uint32_t index) const {
+    const ElfW(Sym)& symbol = this->symbols[index];
+    // the ELF64_ST_* accessors decode ELF32 symbols the same way
+    const auto binding = ELF64_ST_BIND(symbol.st_info);
+    return symbol.st_shndx != SHN_UNDEF && symbol.st_name != 0
+        && (binding == STB_GLOBAL || binding == STB_WEAK || binding == STB_GNU_UNIQUE)
+        && ELF64_ST_VISIBILITY(symbol.st_other) != STV_HIDDEN
+        && (this->versions == nullptr || (this->versions[index] & hiddenVersion) == 0);
+}
+
+std::uint32_t Detail::SymbolResolver::find(const char* name) const {
+    if (this->gnuHash != nullptr) {
+        const std::uint32_t bucketCount = this->gnuHash[0];
+        const std::uint32_t symbolOffset = this->gnuHash[1];
+        const std::uint32_t bloomSize = this->gnuHash[2];
+        const std::uint32_t bloomShift = this->gnuHash[3];
+        const auto* bloom = reinterpret_cast<const ElfW(Addr)*>(this->gnuHash + 4);
+        const auto* buckets = reinterpret_cast<const std::uint32_t*>(bloom + bloomSize);
+        const std::uint32_t* chain = buckets + bucketCount;
+        if (bucketCount == 0 || bloomSize == 0) {
+            return 0;
+        }
+
+        constexpr std::uint32_t wordBits = sizeof(ElfW(Addr)) * 8;
+        const std::uint32_t hash = GnuHash(name);
+        const ElfW(Addr) word = bloom[(hash / wordBits) % bloomSize];
+        const ElfW(Addr) mask = (ElfW(Addr){1} << (hash % wordBits))
+            | (ElfW(Addr){1} << ((hash >> bloomShift) % wordBits));
+        if ((word & mask) != mask) {
+            return 0;
+        }
+        for (std::uint32_t index = buckets[hash % bucketCount]; index >= symbolOffset && index != 0; ++index) {
+            const std::uint32_t chained = chain[index - symbolOffset];
+            if ((hash | 1) == (chained | 1) && this->exported(index)
+                && std::strcmp(name, this->strings + this->symbols[index].st_name) == 0) {
+                return index;
+            }
+            if (chained & 1) {
+                break;
+            }
+        }
+        return 0;
+    }
+    if (this->sysvHash != nullptr) {
+        const std::uint32_t bucketCount = this->sysvHash[0];
+        const std::uint32_t* buckets = this->sysvHash + 2;
+        const std::uint32_t* chain = buckets + bucketCount;
+        if (bucketCount == 0) {
+            return 0;
+        }
+        for (std::uint32_t index = buckets[SysvHash(name) % bucketCount]; index != STN_UNDEF; index = chain[index]) {
+            if (this->exported(index) && std::strcmp(name, this->strings + this->symbols[index].st_name) == 0) {
+                return index;
+            }
+        }
+    }
+    return 0;
+}
+
+std::uint32_t Detail::SymbolResolver::symbolCount() const {
+    if (this->sysvHash != nullptr) {
+        return this->sysvHash[1];
+    }
+    if (this->gnuHash == nullptr) {
+        return 0;
+    }
+    // .gnu.hash has no count, the last chain of the highest bucket ends the table
+    const std::uint32_t bucketCount = this->gnuHash[0];
+    const std::uint32_t symbolOffset = this->gnuHash[1];
+    const auto* bloom = reinterpret_cast<const ElfW(Addr)*>(this->gnuHash + 4);
+    const auto* buckets = reinterpret_cast<const std::uint32_t*>(bloom + this->gnuHash[2]);
+    const std::uint32_t* chain = buckets + bucketCount;
+    std::uint32_t last = 0;
+    for (std::uint32_t bucket = 0; bucket < bucketCount; ++bucket) {
+        last = std::max(last, buckets[bucket]);
+    }
+    if (last < symbolOffset) {
+        return symbolOffset;
+    }
+    while ((chain[last - symbolOffset] & 1) == 0) {
+        ++last;
+    }
+    return last + 1;
+}
+
+std::vector<std::string> Detail::SymbolResolver::functions(const std::string_view prefix) const {
+    std::vector<std::string> names;
+    const std::uint32_t count = this->symbolCount();
+    for (std::uint32_t index = 1; index < count; ++index) {
+        const auto type = ELF64_ST_TYPE(this->symbols[index].st_info);
+        if ((type == STT_FUNC || type == STT_GNU_IFUNC) && this->exported(index)) {
+            if (const std::string_view name = this->strings + this->symbols[index].st_name; name.starts_with(prefix)) {
+                names.emplace_back(name);
+            }
+        }
+    }
+    return names;
+}
+
+std::vector<Detail::ExportedFunction> Detail::SymbolResolver::exports() const {
+    std::vector<ExportedFunction> functions;
+    const std::uint32_t count = this->symbolCount();
+    for (std::uint32_t index = 1; index < count; ++index) {
+        const ElfW(Sym)& symbol = this->symbols[index];
+        if (ELF64_ST_TYPE(symbol.st_info) == STT_FUNC && symbol.st_size != 0 && this->exported(index)) {
+            functions.push_back({this->strings + symbol.st_name, this->base + symbol.st_value, symbol.st_size});
+        }
+    }
+    return functions;
+}
+
+#else
+
+Detail::SymbolResolver::SymbolResolver(const LHANDLE handle) : handle(handle) {}
+
+uintptr_t Detail::SymbolResolver::operator()(const char* name) const {
+    if (this->handle == nullptr) {
+        return 0;
+    }
+    std::shared_lock loader(loaderMutex);
+    return GET_FUNC(this->handle, name);
+}
+
+std::vector<std::string> Detail::SymbolResolver::functions(std::string_view) const {
+    return {};
+}
+
+std::vector<Detail::ExportedFunction> Detail::SymbolResolver::exports() const {
+    return {};
+}
+
+#endif
@@ -0,0 +1,83 @@
+//
+// Created by DS on 2025/12/06.
+//
+
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <shared_mutex>
+#include <unordered_map>
+#include "internal/Fork.h"
+#include "internal/SymbolTable.h"
+
+namespace {
+    constexpr std::size_t shardCount = 16;
+    constexpr std::size_t chunkSize = 1024;
+    constexpr std::size_t chunkCount = 4096;
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string_view, Detail::NameId> ids; //< keys point into `chunks`
+    };
+
+    std::array<Shard, shardCount> shards;
+    // names live in fixed size chunks so NameOf never races with interning
+    std::array<std::atomic<std::string*>, chunkCount> chunks{};
+    std::atomic<Detail::NameId> nextId{0};
+
+    std::string* ChunkOf(const Detail::NameId id) {
+        auto& slot = chunks[id / chunkSize];
+        std::string* chunk = slot.load(std::memory_order_acquire);
+        if (chunk != nullptr) {
+            return chunk;
+        }
+        auto* fresh = new std::string[chunkSize];
+        if (!slot.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+            delete[] fresh;
+            return chunk;
+        }
+        return fresh;
+    }
+}
+
+Detail::NameId Detail::InternName(const std::string_view name) {
+    Shard& shard = shards[std::hash<std::string_view>{}(name) % shardCount];
+    {
+        std::shared_lock lock(shard.mutex);
+        if (const auto id = shard.ids.find(name); id != shard.ids.end()) {
+            return id->second;
+        }
+    }
+    std::unique_lock lock(shard.mutex);
+    if (const auto id = shard.ids.find(name); id != shard.ids.end()) {
+        return id->second;
+    }
+    const NameId id = nextId.fetch_add(1, std::memory_order_relaxed);
+    if (id >= chunkSize * chunkCount) {
+        std::cerr << "too many interned names";
+        std::terminate();
+    }
+    std::string& stored = ChunkOf(id)[id % chunkSize];
+    stored.assign(name);
+    shard.ids.emplace(stored, id);
+    return id;
+}
+
+void Detail::LockNamesForFork() {
+    for (auto& shard : shards) {
+        shard.mutex.lock();
+    }
+}
+
+void Detail::UnlockNamesAfterFork(const bool child) {
+    for (auto& shard : shards | std::views::reverse) {
+        ReleaseAfterFork(shard.mutex, child);
+    }
+}
+
+const std::string& Detail::NameOf(const NameId id) {
+    return chunks[id / chunkSize].load(std::memory_order_acquire)[id % chunkSize];
+}
@@ -0,0 +1,182 @@
+//
+// Created by DS on 2025/12/15.
+//
+
+#include <mutex>
+#include <unordered_map>
+#include "DynamicLink.h"
+#include "internal/CacheManager.h"
+#include "internal/Fork.h"
+#include "internal/Telemetry.h"
+
+namespace {
+    std::mutex recordMutex;
+    Detail::TelemetryRecord* records = nullptr; // never freed, counts of exited threads are kept
+
+    struct FunctionTotals {
+        std::uint64_t calls{0};
+        std::uint64_t fallbacks{0};
+        std::array<std::uint64_t, Detail::histogramBuckets> latency{};
+    };
+    // sums of a slot at the time it was handed to another function, guarded by recordMutex
+    std::unordered_map<std::uint32_t, FunctionTotals> baselines;
+
+    struct RecordRelease {
+        ~RecordRelease() {
+            if (Detail::telemetryRecord != nullptr) {
+                Detail::telemetryRecord->used.store(false, std::memory_order_release);
+                Detail::telemetryRecord = nullptr;
+            }
+        }
+    };
+
+    const Detail::FunctionCounters* FindCounters(const Detail::TelemetryRecord& record, const std::uint32_t index) {
+        constexpr auto blockSize = Detail::TelemetryRecord::blockSize;
+        if (const auto* directory = record.directories[index / blockSize / blockSize].load(std::memory_order_acquire)) {
+            if (const auto* block = (*directory)[index / blockSize % blockSize].load(std::memory_order_acquire)) {
+                return &(*block)[index % blockSize];
+            }
+        }
+        return nullptr;
+    }
+
+    // caller holds recordMutex
+    FunctionTotals SumCounters(const std::uint32_t index) {
+        FunctionTotals totals;
+        for (const auto* record = records; record != nullptr; record = record->next) {
+            if (const auto* counters = FindCounters(*record, index)) {
+                totals.calls += counters->calls.load(std::memory_order_relaxed);
+                totals.fallbacks += counters->fallbacks.load(std::memory_order_relaxed);
+                for (std::size_t i = 0; i < Detail::histogramBuckets; ++i) {
+                    totals.latency[i] += counters->latency.buckets[i].load(std::memory_order_relaxed);
+                }
+            }
+        }
+        return totals;
+    }
+
+    DynamicLink::OperationStats SumOperation(const Detail::Operation operation) {
+        DynamicLink::OperationStats stats;
+        for (const auto* record = records; record != nullptr; record = record->next) {
+            const auto& counters = record->operations[static_cast<std::size_t>(operation)];
+            stats.count += counters.count.load(std::memory_order_relaxed);
+            stats.totalNanoseconds += counters.total.load(std::memory_order_relaxed);
+            stats.maxNanoseconds = std::max(stats.maxNanoseconds, counters.max.load(std::memory_order_relaxed));
+            for (std::size_t i = 0; i < Detail::histogramBuckets; ++i) {
+                stats.latency.buckets[i] += counters.latency.buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+        return stats;
+    }
+}
+
+Detail::TelemetryRecord* Detail::AcquireTelemetryRecord() {
+    thread_local RecordRelease release;
+
+    std::lock_guard lock(recordMutex);
+    TelemetryRecord* record = records;
+    while (record != nullptr && record->used.exchange(true, std::memory_order_acquire)) {
+        record = record->next;
+    }
+    if (record == nullptr) {
+        record = new TelemetryRecord;
+        record->used.store(true, std::memory_order_relaxed);
+        record->next = records;
+        records = record;
+    }
+    telemetryRecord = record;
+    return record;
+}
+
+Detail::FunctionCounters& Detail::AllocateCounters(TelemetryRecord& record, const std::uint32_t index) {
+    constexpr auto blockSize = TelemetryRecord::blockSize;
+    auto& directory = record.directories[index / blockSize / blockSize];
+    if (directory.load(std::memory_order_relaxed) == nullptr) {
+        directory.store(new TelemetryRecord::Directory{}, std::memory_order_release);
+    }
+    auto& block = (*directory.load(std::memory_order_relaxed))[index / blockSize % blockSize];
+    if (block.load(std::memory_order_relaxed) == nullptr) {
+        block.store(new TelemetryRecord::Block{}, std::memory_order_release);
+    }
+    return (*block.load(std::memory_order_relaxed))[index % blockSize];
+}
+
+void Detail::ResetFunctionTelemetry(const std::uint32_t index) {
+    if constexpr (telemetryEnabled) {
+        std::lock_guard lock(recordMutex);
+        baselines[index] = SumCounters(index);
+    }
+}
+
+void Detail::LockTelemetryForFork() {
+    recordMutex.lock();
+}
+
+void Detail::UnlockTelemetryAfterFork(const bool child) {
+    if (child) {
+        // the records of threads the child doesn't have are free again, their counts stay
+        for (TelemetryRecord* record = records; record != nullptr; record = record->next) {
+            if (record != telemetryRecord) {
+                record->used.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+    ReleaseAfterFork(recordMutex, child);
+}
+
+std::uint64_t DynamicLink::LatencyHistogram::samples() const {
+    std::uint64_t total = 0;
+    for (const auto count : this->buckets) {
+        total += count;
+    }
+    return total;
+}
+
+std::uint64_t DynamicLink::LatencyHistogram::percentile(const double fraction) const {
+    const std::uint64_t total = this->samples();
+    if (total == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<std::uint64_t>(fraction * static_cast<double>(total - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < this->buckets.size(); ++i) {
+        if ((seen += this->buckets[i]) >= rank) {
+            return std::uint64_t{1} << i;
+        }
+    }
+    return std::uint64_t{1} << (this->buckets.size() - 1);
+}
+
+DynamicLink::StatsSnapshot DynamicLink::Stats() {
+    StatsSnapshot snapshot;
+    if constexpr (Detail::telemetryEnabled) {
+        snapshot.enabled = true;
+        const auto functions = Detail::CacheManager::instance().cachedFunctions();
+        std::lock_guard lock(recordMutex);
+        for (const auto& [library, function, index] : functions) {
+            FunctionTotals totals = SumCounters(index);
+            if (const auto baseline = baselines.find(index); baseline != baselines.end()) {
+                totals.calls -= baseline->second.calls;
+                totals.fallbacks -= baseline->second.fallbacks;
+                for (std::size_t i = 0; i < Detail::histogramBuckets; ++i) {
+                    totals.latency[i] -= baseline->second.latency[i];
+                }
+            }
+            FunctionStats& stats = snapshot.functions.emplace_back();
+            stats.library = Detail::NameOf(library);
+            stats.function = Detail::NameOf(function);
+            stats.calls = totals.calls;
+            stats.fallbacks = totals.fallbacks;
+            stats.latency.buckets = totals.latency;
+        }
+        for (const auto* record = records; record != nullptr; record = record->next) {
+            snapshot.fallbacks += record->fallbacks.load(std::memory_order_relaxed);
+        }
+        snapshot.resolve = SumOperation(Detail::Operation::Resolve);
+        snapshot.load = SumOperation(Detail::Operation::Load);
+        snapshot.reload = SumOperation(Detail::Operation::Reload);
+        snapshot.reloadPublish = SumOperation(Detail::Operation::ReloadPublish);
+        snapshot.lockWait = SumOperation(Detail::Operation::LockWait);
+    }
+    return snapshot;
+}
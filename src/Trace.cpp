@@ -0,0 +1,158 @@
+//
+// Created by DS on 2025/12/17.
+//
+
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include "internal/Fork.h"
+#include "internal/Trace.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+    struct TraceEvent {
+        const char* name;
+        std::string subject;
+        std::uint64_t start;
+        std::uint64_t end;
+        std::uint32_t thread;
+    };
+
+    std::mutex traceMutex{};
+    std::vector<TraceEvent> traceEvents{};
+
+    std::atomic<bool> perfMap{false};
+    std::mutex perfMapMutex{};
+    std::FILE* perfMapFile = nullptr; //< opened on first use, flushed after every write
+    int inheritedPerfMap = 0;         //< pid of the parent whose map a forked child copies first
+
+    std::uint32_t ThreadOrdinal() {
+        static std::atomic<std::uint32_t> threads{0};
+        thread_local const std::uint32_t ordinal = threads.fetch_add(1, std::memory_order_relaxed) + 1;
+        return ordinal;
+    }
+
+    std::string EscapeJson(const std::string_view text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (const char character : text) {
+            if (character == '"' || character == '\\') {
+                escaped += '\\';
+                escaped += character;
+            } else if (static_cast<unsigned char>(character) < 0x20) {
+                escaped += std::format("\\u{:04x}", static_cast<unsigned>(character));
+            } else {
+                escaped += character;
+            }
+        }
+        return escaped;
+    }
+
+    int ProcessId() {
+#ifdef __linux__
+        return getpid();
+#else
+        return 0;
+#endif
+    }
+}
+
+void Detail::StartTrace() {
+    std::lock_guard lock(traceMutex);
+    traceEvents.clear();
+    tracing.store(true, std::memory_order_relaxed);
+}
+
+bool Detail::StopTrace(const std::string& file) {
+    tracing.store(false, std::memory_order_relaxed);
+    std::vector<TraceEvent> events;
+    {
+        std::lock_guard lock(traceMutex);
+        events.swap(traceEvents);
+    }
+    std::ofstream output(file, std::ios::trunc);
+    if (!output) {
+        return false;
+    }
+    // complete ("X") events, timestamps and durations in microseconds
+    const int process = ProcessId();
+    output << "{\"traceEvents\":[";
+    for (std::size_t index = 0; index < events.size(); ++index) {
+        const auto& [name, subject, start, end, thread] = events[index];
+        output << (index == 0 ? "\n" : ",\n") << std::format(
+            R"({{"name":"{}","cat":"DynamicLink","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":{},"tid":{},"args":{{"subject":"{}"}}}})",
+            name, static_cast<double>(start) / 1000.0, static_cast<double>(end - start) / 1000.0,
+            process, thread, EscapeJson(subject));
+    }
+    output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(output);
+}
+
+void Detail::RecordTraceEvent(const char* name, const std::string_view subject,
+    const std::uint64_t start, const std::uint64_t end) {
+    std::lock_guard lock(traceMutex);
+    if (tracing.load(std::memory_order_relaxed)) {
+        traceEvents.push_back({name, std::string(subject), start, end, ThreadOrdinal()});
+    }
+}
+
+void Detail::SetPerfMap(const bool enable) {
+    perfMap.store(enable, std::memory_order_relaxed);
+}
+
+bool Detail::PerfMapEnabled() {
+    return perfMap.load(std::memory_order_relaxed);
+}
+
+void Detail::WritePerfMap(const std::vector<ExportedFunction>& functions, const std::string_view library) {
+    if (functions.empty()) {
+        return;
+    }
+    std::lock_guard lock(perfMapMutex);
+    if (perfMapFile == nullptr) {
+        // perf reads the file at report time, entries are only ever appended
+        perfMapFile = std::fopen(std::format("/tmp/perf-{}.map", ProcessId()).c_str(), "a");
+        if (perfMapFile == nullptr) {
+            return;
+        }
+        // the child runs the code the parent mapped before fork()
+        if (inheritedPerfMap != 0) {
+            if (std::FILE* parent = std::fopen(std::format("/tmp/perf-{}.map", inheritedPerfMap).c_str(), "r")) {
+                char buffer[4096];
+                for (std::size_t count; (count = std::fread(buffer, 1, sizeof(buffer), parent)) != 0;) {
+                    std::fwrite(buffer, 1, count, perfMapFile);
+                }
+                std::fclose(parent);
+            }
+            inheritedPerfMap = 0;
+        }
+    }
+    for (const auto& [name, address, size] : functions) {
+        std::fputs(std::format("{:x} {:x} {} [{}]\n", address, size, name, library).c_str(), perfMapFile);
+    }
+    std::fflush(perfMapFile);
+}
+
+void Detail::LockTraceForFork() {
+    traceMutex.lock();
+    perfMapMutex.lock();
+}
+
+void Detail::UnlockTraceAfterFork(const bool child) {
+    if (child) {
+        traceEvents.clear(); // the parent writes the timeline
+#ifdef __linux__
+        if (perfMapFile != nullptr) {
+            std::fclose(perfMapFile);
+            perfMapFile = nullptr;
+            inheritedPerfMap = getppid();
+        }
+#endif
+    }
+    ReleaseAfterFork(perfMapMutex, child);
+    ReleaseAfterFork(traceMutex, child);
+}
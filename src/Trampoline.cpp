@@ -0,0 +1,106 @@
+//
+// Created by DS on 2025/12/14.
+//
+
+#include <cstring>
+#include <iostream>
+#include "internal/Trampoline.h"
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define DYNAMICLINK_TRAMPOLINES 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef DYNAMICLINK_TRAMPOLINES
+    std::size_t PageSize() {
+        static const auto size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    // the slot of an entry lies exactly one page behind it
+    void WriteEntry(std::byte* code) {
+        const std::size_t page = PageSize();
+#if defined(__x86_64__)
+        // jmp qword ptr [rip + page - 6]; int3; int3
+        const auto displacement = static_cast<std::int32_t>(page - 6);
+        const unsigned char jump[2] = {0xFF, 0x25};
+        std::memcpy(code, jump, sizeof(jump));
+        std::memcpy(code + 2, &displacement, sizeof(displacement));
+        code[6] = code[7] = std::byte{0xCC};
+#elif defined(__aarch64__)
+        // ldr x16, #page; br x16
+        const std::uint32_t load = 0x58000000U | static_cast<std::uint32_t>(page / 4) << 5 | 16U;
+        const std::uint32_t branch = 0xD61F0200U;
+        std::memcpy(code, &load, sizeof(load));
+        std::memcpy(code + 4, &branch, sizeof(branch));
+#endif
+    }
+#endif
+}
+
+std::uint32_t Detail::TrampolineTable::allocate(const uintptr_t target) {
+#ifdef DYNAMICLINK_TRAMPOLINES
+    const std::size_t page = PageSize();
+    const auto perBlock = static_cast<std::uint32_t>(page / entrySize);
+    std::lock_guard lock(this->mutex);
+    const std::uint32_t index = this->next;
+    if (index == perBlock * blockCount) {
+        std::cerr << "trampoline table exhausted";
+        std::terminate();
+    }
+    if (index % perBlock == 0) {
+        void* memory = mmap(nullptr, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            std::cerr << "failed to map trampoline block";
+            std::terminate();
+        }
+        auto* code = static_cast<std::byte*>(memory);
+        for (std::size_t offset = 0; offset < page; offset += entrySize) {
+            WriteEntry(code + offset);
+        }
+        if (mprotect(code, page, PROT_READ | PROT_EXEC) != 0) {
+            std::cerr << "failed to make trampoline block executable";
+            std::terminate();
+        }
+        __builtin___clear_cache(reinterpret_cast<char*>(code), reinterpret_cast<char*>(code + page));
+        this->blocks[index / perBlock].store(code, std::memory_order_release);
+    }
+    this->slot(index).store(target, std::memory_order_release);
+    ++this->next;
+    return index;
+#else
+    static_cast<void>(target);
+    std::cerr << "stable function pointers are only supported on x86-64 and AArch64 Linux";
+    std::terminate();
+#endif
+}
+
+std::byte* Detail::TrampolineTable::block(const std::uint32_t index) const noexcept {
+#ifdef DYNAMICLINK_TRAMPOLINES
+    const auto perBlock = static_cast<std::uint32_t>(PageSize() / entrySize);
+    return this->blocks[index / perBlock].load(std::memory_order_acquire) + index % perBlock * entrySize;
+#else
+    static_cast<void>(index);
+    return nullptr;
+#endif
+}
+
+std::atomic<uintptr_t>& Detail::TrampolineTable::slot(const std::uint32_t index) const noexcept {
+#ifdef DYNAMICLINK_TRAMPOLINES
+    return *reinterpret_cast<std::atomic<uintptr_t>*>(this->block(index) + PageSize());
+#else
+    static_cast<void>(index);
+    std::terminate();
+#endif
+}
+
+void* Detail::TrampolineTable::entry(const std::uint32_t index) const noexcept {
+    return this->block(index);
+}
+
+void Detail::MissingStableTarget() {
+    std::cerr << "stable function pointer called while its library is not loaded";
+    std::terminate();
+}